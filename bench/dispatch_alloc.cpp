@@ -0,0 +1,84 @@
+/**
+ * @file   dispatch_alloc.cpp
+ * @brief  Counts heap allocations per dispatch of an input whose name is
+ *         too long for the small-string buffer.
+ *
+ * Two cases: the guard rejects the input (nothing fires), and the input
+ * fires a self-loop (the event log records the trigger).  The first one
+ * should not allocate at all.
+ *
+ * Usage: `dispatch_alloc [iterations]`
+ *
+ * @author Martin Ševčík (xsevcim00)
+ * @author Jakub Lůčný (xlucnyj00)
+ * @date   2025-05-06
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+#include "automaton.hpp"
+
+namespace {
+std::size_t g_allocs = 0;   // operator new calls so far
+}
+
+void* operator new(std::size_t n) {
+    ++g_allocs;
+    if (void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t n) { return operator new(n); }
+void  operator delete(void* p) noexcept { std::free(p); }
+void  operator delete[](void* p) noexcept { std::free(p); }
+void  operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void  operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+using namespace core_fsm;
+
+/**
+ * Dispatches @p trigger on @p fsm @p iterations times and prints the
+ * allocations and time per dispatch.
+ */
+static void measure(const char* label, Automaton& fsm, const std::string& trigger,
+                    std::size_t iterations)
+{
+    fsm.processImmediateTransitions(trigger);   // Warm-up: lazy index, first log entry
+
+    const std::size_t before = g_allocs;
+    const auto started = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < iterations; ++i)
+        fsm.processImmediateTransitions(trigger);
+    const std::chrono::duration<double, std::nano> took = std::chrono::steady_clock::now() - started;
+
+    std::printf("%-24s %8.3f allocs/dispatch %8.1f ns/dispatch\n", label,
+                double(g_allocs - before) / double(iterations), took.count() / double(iterations));
+}
+
+int main(int argc, char** argv)
+{
+    const std::size_t iterations = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200000;
+    const std::string trigger = "sensor_temperature_reading";   // 26 chars: heap-allocated copy
+
+    // Guard fails: the dispatch looks the row up and evaluates the guard only
+    Automaton rejected(Scheduler::Backend::Heap);
+    rejected.addInput(trigger);
+    rejected.addState(State{"IDLE"}, true);
+    rejected.addState(State{"HOT"});
+    rejected.addTransition(Transition(trigger, "valueof(\"" + trigger + "\") == \"hot\"",
+                                      std::chrono::milliseconds(0), 0, 1));
+    rejected.setRunToCompletion(true);
+    measure("guard rejects", rejected, trigger, iterations);
+
+    // Self-loop fires: the log entry and its strings are the expected cost
+    Automaton fired(Scheduler::Backend::Heap);
+    fired.addInput(trigger);
+    fired.addState(State{"IDLE"}, true);
+    fired.addTransition(Transition(trigger, "", std::chrono::milliseconds(0), 0, 0));
+    fired.setRunToCompletion(true);
+    measure("self-loop fires", fired, trigger, iterations);
+    return 0;
+}
@@ -0,0 +1,126 @@
+/**
+ * @file   input_queue.cpp
+ * @brief  Contention benchmark of the automaton input queues: MutexQueue
+ *         (the default) against the lock-free MpscRing.
+ *
+ * Producers push name/value events the way Automaton::injectInput does
+ * (yield and wake the consumer when the queue is full), one consumer parks
+ * while it is empty and drains it in batches like the run loop.  Prints
+ * the best of three runs in millions of events per second for 1 to 16
+ * producers, and checks per-producer FIFO delivery on the way.
+ *
+ * Run it on a multi-core machine before changing FSM_LOCKFREE_INPUT_QUEUE;
+ * on a single CPU the figures mostly reflect scheduling.
+ *
+ * Usage: `input_queue [events]`
+ *
+ * @author Martin Ševčík (xsevcim00)
+ * @author Jakub Lůčný (xlucnyj00)
+ * @date   2025-05-06
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "mpsc_queue.hpp"
+#include "mutex_queue.hpp"
+#include "parker.hpp"
+
+using namespace core_fsm;
+
+namespace {
+
+/// Same shape as Automaton's queued input
+struct Event {
+    std::string name;
+    std::string value;
+    std::size_t producer{0};
+    std::size_t seq{0};
+};
+
+constexpr std::size_t kCapacity = 4096;   // Automaton::kInputQueueCapacity
+
+/**
+ * Pushes @p events events from @p producers threads through a fresh
+ * @p Queue.
+ * @return Events per second, or 0 if an event was lost or reordered.
+ */
+template<typename Queue>
+double runOnce(std::size_t producers, std::size_t events)
+{
+    Queue queue(kCapacity);
+    Parker wakeup;
+    const std::size_t perProducer = events / producers;
+    const std::size_t total = perProducer * producers;
+
+    const auto started = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (std::size_t p = 0; p < producers; ++p) {
+        threads.emplace_back([&, p] {
+            const std::string name = "sensor_" + std::to_string(p);
+            for (std::size_t i = 0; i < perProducer; ++i) {
+                auto write = [&](Event& e) {
+                    e.name.assign(name);
+                    e.value.assign("42");
+                    e.producer = p;
+                    e.seq = i;
+                };
+                while (!queue.tryPush(write)) {
+                    wakeup.unpark();
+                    std::this_thread::yield();
+                }
+                wakeup.unpark();
+            }
+        });
+    }
+
+    std::vector<std::size_t> next(producers, 0);
+    std::size_t received = 0;
+    bool ordered = true;
+    while (received < total) {
+        if (queue.empty())
+            wakeup.park(std::chrono::milliseconds(10));
+        received += queue.drain([&](Event& e) {
+            ordered &= e.seq == next[e.producer]++;
+        }, queue.capacity());
+    }
+    const std::chrono::duration<double> took = std::chrono::steady_clock::now() - started;
+    for (auto& t : threads) t.join();
+    return ordered ? double(total) / took.count() : 0.0;
+}
+
+/// Best of three runs of runOnce()
+template<typename Queue>
+double best(std::size_t producers, std::size_t events)
+{
+    double rate = 0.0;
+    for (int run = 0; run < 3; ++run)
+        rate = std::max(rate, runOnce<Queue>(producers, events));
+    return rate;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const std::size_t events = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200000;
+
+    std::printf("%u hardware threads, %zu events, Mevents/s (best of 3)\n",
+                std::thread::hardware_concurrency(), events);
+    std::printf("%9s %12s %12s\n", "producers", "MutexQueue", "MpscRing");
+    for (std::size_t producers : {1, 2, 4, 8, 16}) {
+        const double mutex = best<MutexQueue<Event>>(producers, events);
+        const double ring  = best<MpscRing<Event>>(producers, events);
+        std::printf("%9zu %12.2f %12.2f\n", producers, mutex / 1e6, ring / 1e6);
+        if (mutex == 0.0 || ring == 0.0) {
+            std::fprintf(stderr, "events lost or reordered\n");
+            return 1;
+        }
+    }
+    return 0;
+}
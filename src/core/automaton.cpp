@@ -10,32 +10,39 @@
  */
 
 #include "automaton.hpp"
+#include "dispatch.hpp"
 #include "scheduler.hpp"
+#include "log.hpp"
+#include "io/snapshot_sender.hpp"
 #include <nlohmann/json.hpp>
-#include <iostream>
-#include <QDebug>
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
 
 using namespace core_fsm;
 
-namespace {
-    // Build a simple name→Value map for guard evaluation
-    static std::unordered_map<std::string, Value>
-    makeVarSnapshot(const std::unordered_map<std::string, Variable>& vars) {
-        std::unordered_map<std::string, Value> snap;
-        snap.reserve(vars.size());
-        for (auto const& kv : vars)
-            snap.emplace(kv.first, kv.second.value());
-        return snap;
-    }
-}
+/// Delay before a snapshot refused by a full sender ring is tried again
+static constexpr std::chrono::milliseconds kPublishRetry{1};
 
 /**
- * Helper function that converts a Value variant into JSON representation.
- * Uses std::visit to handle different value types appropriately.
+ * Starts on a frozen model: the slot templates carry the declared names
+ * and initial values, so slot ids match the ones the model was bound to.
  */
-static nlohmann::json jsonFromValue(const core_fsm::Value &v) {
-    return std::visit([](auto&& x) -> nlohmann::json { return x; }, v);
-}
+Automaton::Automaton(std::shared_ptr<const CompiledFsm> model,
+                     Scheduler::Backend timers,
+                     std::size_t inputCapacity)
+    : scheduler_(timers)
+    , m_draft(nullptr)
+    , m_model(std::move(model))
+    , m_active(m_model->initialState())
+    , m_dispatchDirty(false)
+    , m_runToCompletion(m_model->runToCompletion())
+    , m_maxMicrosteps(m_model->maxMicrosteps())
+    , m_vars(m_model->initialVars())
+    , m_inputs(m_model->inputLayout())
+    , m_incoming(inputCapacity)
+    , m_outputs(m_model->outputLayout())
+{}
 
 /**
  * Registers a new internal variable in the automaton.
@@ -43,7 +50,22 @@ static nlohmann::json jsonFromValue(const core_fsm::Value &v) {
  */
 void Automaton::addVariable(const Variable& var) {
     // Register a new internal variable
-    m_vars.emplace(var.name(), var);
+    m_vars.add(var);
+}
+
+/**
+ * Declares an input port, resolving its name to a slot id at load time.
+ * Inputs that are not declared still get a slot the first time they arrive.
+ */
+void Automaton::addInput(const std::string& name) {
+    m_inputs.declare(name);
+}
+
+/**
+ * Declares an output port, resolving its name to a slot id at load time.
+ */
+void Automaton::addOutput(const std::string& name) {
+    m_outputs.declare(name);
 }
 
 /**
@@ -51,10 +73,14 @@ void Automaton::addVariable(const Variable& var) {
  * If this is the first state or initial=true, it becomes the initial state.
  */
 void Automaton::addState(const State& s, bool initial) {
+    if (!m_draft) throw std::logic_error("addState: the model is shared");
+
     // Append state and optionally mark as initial
-    m_states.push_back(s);
-    if (m_states.size() == 1 || initial)
-        m_active = m_states.size() - 1;
+    auto& states = m_draft->m_states;
+    states.push_back(s);
+    if (states.size() == 1 || initial)
+        m_active = states.size() - 1;
+    m_dispatchDirty = true;
 }
 
 /**
@@ -62,8 +88,92 @@ void Automaton::addState(const State& s, bool initial) {
  * The transition becomes part of the available paths in the state machine.
  */
 void Automaton::addTransition(const Transition& t) {
+    if (!m_draft) throw std::logic_error("addTransition: the model is shared");
+
     // Append transition
-    m_transitions.push_back(t);
+    m_draft->m_transitions.push_back(t);
+    m_dispatchDirty = true;
+}
+
+/**
+ * Builds the CSR dispatch table used by processImmediateTransitions().
+ * Transitions are bucketed by source state with a counting pass, then each
+ * bucket is ordered by trigger id so a lookup is a binary search over the
+ * active state's outgoing transitions only.
+ */
+void Automaton::buildDispatchIndex() {
+    if (!m_draft) return;   // Shared models are complete
+
+    using DispatchEntry = CompiledFsm::DispatchEntry;
+    auto& states        = m_draft->m_states;
+    auto& transitions   = m_draft->m_transitions;
+    auto& dispatchStart = m_draft->m_dispatchStart;
+    auto& dispatch      = m_draft->m_dispatch;
+    auto& delayVar      = m_draft->m_delayVar;
+
+    dispatchStart.assign(states.size() + 1, 0);
+    dispatch.clear();
+    delayVar.assign(transitions.size(), kNoSymbol);
+
+    // Native entry actions write outputs and read inputs by slot id
+    for (auto& st : states)
+        st.bindSlots(m_inputs, m_vars, m_outputs);
+
+    // Resolve names to slots and count outgoing transitions per state
+    for (std::size_t i = 0; i < transitions.size(); ++i) {
+        auto& t = transitions[i];
+        m_inputs.declare(t.inputName());
+        t.bindSlots(m_inputs, m_vars);
+        if (t.hasVariableDelay())
+            delayVar[i] = m_vars.find(t.variableDelayName());
+        if (t.src() < states.size())
+            ++dispatchStart[t.src() + 1];
+    }
+    for (std::size_t s = 0; s < states.size(); ++s)
+        dispatchStart[s + 1] += dispatchStart[s];
+
+    // Scatter into rows, keeping definition order inside each row
+    dispatch.resize(dispatchStart.back());
+    std::vector<std::uint32_t> fill(dispatchStart.begin(), dispatchStart.end() - 1);
+    for (std::size_t i = 0; i < transitions.size(); ++i) {
+        const auto& t = transitions[i];
+        if (t.src() >= states.size()) continue;
+        dispatch[fill[t.src()]++] = DispatchEntry{
+            m_inputs.find(t.inputName()), static_cast<std::uint32_t>(i)};
+    }
+
+    // Order each row by trigger; stable so equal triggers keep their order
+    for (std::size_t s = 0; s < states.size(); ++s) {
+        std::stable_sort(dispatch.begin() + dispatchStart[s],
+                         dispatch.begin() + dispatchStart[s + 1],
+                         [](const DispatchEntry& a, const DispatchEntry& b) {
+                             return a.trigger < b.trigger;
+                         });
+    }
+    m_draft->m_unconditional = m_inputs.find("");
+    m_dispatchDirty = false;
+}
+
+/**
+ * Finishes the draft model and hands it out.  The slot templates are
+ * copies of the current slots with the port values cleared; names are
+ * shared copy-on-write, so every instance resolves the same ids.
+ */
+std::shared_ptr<const CompiledFsm> Automaton::share() {
+    if (!m_draft) return m_model;
+    if (m_dispatchDirty) buildDispatchIndex();
+
+    m_draft->m_initial         = m_active;
+    m_draft->m_vars            = m_vars;
+    m_draft->m_inputs          = m_inputs;
+    m_draft->m_outputs         = m_outputs;
+    m_draft->m_inputs.clear();
+    m_draft->m_outputs.clear();
+    m_draft->m_runToCompletion = m_runToCompletion;
+    m_draft->m_maxMicrosteps   = m_maxMicrosteps;
+
+    m_draft.reset();   // Frozen from here on
+    return m_model;
 }
 
 /**
@@ -74,11 +184,76 @@ void Automaton::injectInput(const std::string& name,
                             const std::string& value)
 {
     // Queue external input and wake run loop
-    {
-        std::lock_guard<std::mutex> lk(m_mtx);
-        m_incoming.emplace(name, value);
+    auto write = [&](InputEvent& e) {
+        e.kind = Injection::Kind::Input;
+        e.name.assign(name);
+        e.value.assign(value);
+        e.deferSnapshot = false;
+    };
+    while (!m_incoming.tryPush(write)) {
+        // Full: make sure the queue is being drained, then retry
+        waitForRoom();
     }
-    m_cv.notify_one();
+    wake();
+}
+
+/**
+ * Queues a run of events so that no other producer's events land inside it.
+ * Runs longer than the queue are split into queue-sized chunks; only the
+ * last event of the whole run ends the batch.
+ */
+template<typename Fill>
+void Automaton::enqueueBatch(std::size_t count, Fill&& fill)
+{
+    std::size_t done = 0;
+    while (done < count) {
+        const std::size_t n = std::min(count - done, m_incoming.capacity());
+        auto write = [&](std::size_t i, InputEvent& e) {
+            fill(done + i, e);
+            e.deferSnapshot = done + i + 1 < count;
+        };
+        while (!m_incoming.tryPushN(n, write))
+            waitForRoom();
+        done += n;
+    }
+    // One wakeup for the whole batch
+    wake();
+}
+
+/**
+ * Queues a batch of input and variable updates for processing as one unit.
+ */
+void Automaton::injectBatch(const Injection* entries, std::size_t count)
+{
+    enqueueBatch(count, [&](std::size_t i, InputEvent& e) {
+        e.kind = entries[i].kind;
+        e.name.assign(entries[i].name);
+        e.value.assign(entries[i].value);
+    });
+}
+
+/**
+ * Queues a batch of inputs for processing as one unit.
+ */
+void Automaton::injectInputs(const std::vector<std::pair<std::string, std::string>>& inputs)
+{
+    enqueueBatch(inputs.size(), [&](std::size_t i, InputEvent& e) {
+        e.kind = Injection::Kind::Input;
+        e.name.assign(inputs[i].first);
+        e.value.assign(inputs[i].second);
+    });
+}
+
+/**
+ * Queues a keyframe request; the run loop answers it with a full snapshot.
+ */
+void Automaton::requestKeyframe()
+{
+    enqueueBatch(1, [](std::size_t, InputEvent& e) {
+        e.kind = Injection::Kind::Keyframe;
+        e.name.clear();
+        e.value.clear();
+    });
 }
 
 /**
@@ -87,11 +262,8 @@ void Automaton::injectInput(const std::string& name,
  */
 void Automaton::requestStop() noexcept {
     // Signal run loop to exit
-    {
-        std::lock_guard<std::mutex> lk(m_mtx);
-        m_stop = true;
-    }
-    m_cv.notify_one();
+    m_stop.store(true, std::memory_order_release);
+    wake();
 }
 
 /**
@@ -99,7 +271,7 @@ void Automaton::requestStop() noexcept {
  * Provides a read-only view of the current state for monitoring purposes.
  */
 const std::string& Automaton::currentState() const noexcept {
-    return m_states[m_active].name();
+    return m_model->states()[m_active].name();
 }
 
 /**
@@ -113,30 +285,107 @@ Automaton::log() const noexcept
 }
 
 /**
- * Sends the current state snapshot through the connected channel.
- * Creates a JSON representation of the current state, variables, inputs, and outputs.
+ * Sends the current state snapshot through the connected channel (or its sender thread).
+ * Creates a JSON representation of the current state, variables, inputs, and outputs;
+ * in delta mode only the entries changed since the previous message, with
+ * periodic full keyframes.  Encoded in the wire format the client negotiated.
  */
 void Automaton::broadcastSnapshot() {
-    if (!m_channel) return;
-
-    // Build and send JSON snapshot
-    nlohmann::json j = {
-        {"type",    "state"},
-        {"seq",     ++m_seq},
-        {"ts",      std::chrono::duration_cast<Duration>(
-                        Clock::now().time_since_epoch()).count()},
-        {"state",   m_states[m_active].name()},
-        {"inputs",  m_inputs},
-        {"vars",    [&]{
-            nlohmann::json snap;
-            for (auto &kv : m_vars)
-                snap[kv.first] = jsonFromValue(kv.second.value());
-            return snap;
-        }()},
-        {"outputs", m_outputs}
+    if (!m_channel && !m_sender) return;
+
+    // Every event takes a number; unsent ones show up as gaps in "seq"
+    ++m_seq;
+    if (!m_keyframeDue) {
+        switch (m_policy.mode) {
+        case PublishPolicy::Mode::OnStateChange:
+            if (m_active == m_publishedState) return;
+            break;
+        case PublishPolicy::Mode::Interval: {
+            // Too soon: the latest event goes out when the interval ends
+            const auto now = m_time->now();
+            if (now - m_publishedAt < m_policy.interval) {
+                m_flushAt = m_publishedAt + m_policy.interval;
+                return;
+            }
+            break;
+        }
+        default:
+            break;
+        }
+    }
+    sendSnapshot();
+}
+
+/**
+ * Takes snapshot number m_seq and sends it, or hands it to the sender thread.
+ */
+void Automaton::sendSnapshot() {
+    const auto now = m_time->now();
+    const bool key = m_keyframeEvery == 0 || m_keyframeDue ||
+                     m_sinceKeyframe + 1 >= m_keyframeEvery;
+    if (key) { m_sinceKeyframe = 0; m_keyframeDue = false; }
+    else     ++m_sinceKeyframe;
+
+    if (m_sender) {
+        const bool queued = m_sender->tryPublish([&](SnapshotRecord& r) { fillSnapshot(r, key, now); });
+        if (!queued) {
+            // Nothing counts as sent, so the next delta covers these changes
+            if (key) m_keyframeDue = true;
+            if (m_sender->overflow() == io_bridge::SnapshotSender::Overflow::Coalesce)
+                m_flushAt = now + kPublishRetry;
+            return;
+        }
+    }
+    else {
+        fillSnapshot(m_record, key, now);
+        const auto j = toJson(m_record);
+        io_bridge::encode(j, m_record.format, m_outgoing.json);
+        FSM_LOG(Snapshot, Debug, "RUNTIME → UDP: " << j.dump());
+        m_channel->send(m_outgoing);
+    }
+
+    m_sentInputs  = m_inputs.generation();
+    m_sentVars    = m_vars.generation();
+    m_sentOutputs = m_outputs.generation();
+    m_publishedState = m_active;
+    m_publishedSeq   = m_seq;
+    m_publishedAt    = now;
+    m_flushAt.reset();
+}
+
+/**
+ * Fills a snapshot record: the state plus every input, variable and output
+ * (a keyframe) or those stamped after the last message (a delta).
+ */
+void Automaton::fillSnapshot(SnapshotRecord& r, bool key, TimePoint now) const {
+    auto ports = [&](const IOSlots& slots, std::uint64_t since, SnapshotRecord::EntryList& out) {
+        for (SymbolId id = 0; id < slots.size(); ++id) {
+            const bool has = slots.has(id);
+            if (!(key ? has : slots.stamp(id) > since)) continue;
+            auto& e = out.push();
+            e.name.assign(slots.name(id));
+            e.unset = !has;   // Unset since the last message
+            if (has) e.value = slots.get(id);
+        }
     };
-    m_channel->send({ j.dump() });
-    std::cerr << "RUNTIME → UDP: " << j.dump() << std::endl;
+
+    r.clear();
+    r.key    = key;
+    r.seq    = m_seq;
+    r.prev   = m_publishedSeq;   // The message a delta applies to
+    r.ts     = std::chrono::duration_cast<Duration>(now.time_since_epoch()).count();
+    r.format = wireFormat();
+    r.state.assign(m_model->states()[m_active].name());
+    ports(m_inputs, m_sentInputs, r.inputs);
+    for (SymbolId id = 0; id < m_vars.size(); ++id) {
+        if (key || m_vars.stamp(id) > m_sentVars) {
+            auto& e = r.vars.push();
+            e.name.assign(m_vars.name(id));
+            e.value = m_vars.value(id);
+            e.unset = false;
+        }
+    }
+    ports(m_outputs, m_sentOutputs, r.outputs);
 }
 
 /**
@@ -150,27 +399,32 @@ void Automaton::broadcastSnapshot() {
 bool Automaton::fireTransition(size_t idx,
                             const std::string& trigger)
 {
-    const auto& t = m_transitions[idx];
+    const CompiledFsm& model = *m_model;
+    const auto& t = model.transitions()[idx];
     if (t.src() != m_active) return false;
 
     // Change state and log event
     auto old = m_active;
     m_active = t.dst();
-    m_log.emplace_back(Clock::now(),
-                    m_states[m_active].name(),
+    m_log.emplace_back(m_time->now(),
+                    model.states()[m_active].name(),
                     trigger,
                     std::string{});
+    if (m_recorder)
+        m_recorder->write(TraceRecord::Kind::State, m_log.back().timestamp,
+                          m_log.back().state, trigger);
     if (m_snapshotHook) m_snapshotHook();
 
-    // Remove timers for this state and reset timer if changed
-    scheduler_.purgeForState(m_active,
-        [&](size_t i){ return m_transitions[i].src(); });
-    if (m_active != old)
-        m_stateSince = Clock::now();
+    // Entering a different state starts a new timer epoch, which retires
+    // every pending timer in O(1); self-loops keep their timers and clock
+    if (m_active != old) {
+        m_stateSince = m_time->now();
+        scheduler_.newEpoch();
+    }
 
     // Invoke onEnter handler
-    Context ctx{m_vars, m_inputs, m_outputs, m_stateSince};
-    m_states[m_active].onEnter(ctx);
+    Context ctx{m_vars, m_inputs, m_outputs, m_stateSince, m_time->now(), &m_actionJs};
+    model.states()[m_active].onEnter(ctx);
 
     m_inputs.clear();
     return true;
@@ -184,35 +438,31 @@ bool Automaton::fireTransition(size_t idx,
  * @return true if any immediate transition was fired
  */
 bool Automaton::processImmediateTransitions(const std::string& trigger) {
-    // Arm any transitions whose guard fires right now
-    auto varSnap = makeVarSnapshot(m_vars);
-    GuardCtx guardCtx{varSnap, m_inputs};
-
-    for (size_t i = 0; i < m_transitions.size(); ++i) {
-        const auto& t = m_transitions[i];
-        if (t.src() == m_active &&
-            t.isTriggered(trigger, guardCtx))
-        {
-            // Determine delay: variable, fixed, or 1ms default
-            Duration delay{1};
-            if (t.hasVariableDelay()) {
-                auto it = m_vars.find(t.variableDelayName());
-                if (it != m_vars.end()) {
-                    if (auto iv = std::get_if<int>(&it->second.value()))
-                        delay = Duration(*iv);
-                    else if (auto dv = std::get_if<double>(&it->second.value()))
-                        delay = Duration(static_cast<int>(*dv));
-                }
-            }
-            else if (t.isDelayed()) {
-                delay = t.delay();
-            }
-            qDebug() << "[arm]" << t.src() << "→" << t.dst()
-                    << "delay=" << delay.count() << "ms";
-            scheduler_.arm(i, delay);
-        }
-    }
-    return false;
+    if (m_dispatchDirty) buildDispatchIndex();
+    return processImmediateTransitions(m_inputs.find(trigger));
+}
+
+/**
+ * Slot-based variant: the trigger has already been resolved to its input
+ * slot (as done by run() when the input value is stored).
+ *
+ * The dispatch, delay and arm rules (run-to-completion microsteps and the
+ * livelock guard included) are the ones FsmInstance uses, see Dispatch.
+ */
+bool Automaton::processImmediateTransitions(SymbolId trig) {
+    if (m_dispatchDirty) buildDispatchIndex();
+
+    // Guards read the live slots directly (JS guards through the
+    // incrementally synced mirror)
+    Dispatch<Scheduler> dispatch{*m_model, m_active, m_vars,
+                                 GuardCtx{m_vars, m_inputs, &m_guardJs},
+                                 scheduler_, *m_time,
+                                 m_runToCompletion, m_maxMicrosteps, m_livelockReported};
+    // The trigger's name is only needed when a transition fires (for the
+    // log); it is read from the slot, not copied per dispatch
+    return dispatch.run(trig, [this](std::size_t next, SymbolId via) {
+        fireTransition(next, m_inputs.name(via));
+    });
 }
 
 /**
@@ -223,25 +473,25 @@ bool Automaton::processImmediateTransitions(const std::string& trigger) {
 void Automaton::setVariable(const std::string& name,
                             const std::string& valueStr) noexcept
 {
-    auto it = m_vars.find(name);
-    if (it == m_vars.end()) return;
+    SymbolId id = m_vars.find(name);
+    if (id == kNoSymbol) return;
 
     // Parse incoming string into the stored variant type
     try {
-        switch (it->second.type()) {
+        switch (m_vars.type(id)) {
         case Variable::Type::Int:
-            it->second.set(std::stoi(valueStr));
+            m_vars.set(id, std::stoi(valueStr));
             break;
         case Variable::Type::Double:
-            it->second.set(std::stod(valueStr));
+            m_vars.set(id, std::stod(valueStr));
             break;
         case Variable::Type::String:
         default:
-            it->second.set(valueStr);
+            m_vars.set(id, valueStr);
         }
     }
     catch (...) {
-        it->second.set(valueStr);
+        m_vars.set(id, valueStr);
     }
 }
 
@@ -251,41 +501,118 @@ void Automaton::setVariable(const std::string& name,
  * Broadcasts state changes to monitoring clients as they happen.
  */
 void Automaton::run() {
-    // Send initial snapshot
-    broadcastSnapshot();
+    start();
 
     while (!m_stop) {
         // Fire zero-delay transitions
         if (processImmediateTransitions(""))
             broadcastSnapshot();
 
-        // Wait for the next timeout or input
-        auto next = scheduler_.nextTimeout().value_or(std::chrono::hours(24));
-        {
-            std::unique_lock<std::mutex> lk(m_mtx);
-            m_cv.wait_for(lk, next, [&]{ return m_stop || !m_incoming.empty(); });
-            if (m_stop) break;
-        }
+        // Wait for the next timeout or input; producers only enter the
+        // kernel to wake us when we are actually parked
+        auto next = scheduler_.nextTimeout(m_time->now()).value_or(std::chrono::hours(24));
+        if (m_flushAt)
+            next = std::min<Duration>(next, std::chrono::ceil<Duration>(*m_flushAt - m_time->now()));
+        if (m_incoming.empty())
+            m_wakeup.park(next);
+        if (m_stop) break;
 
-        // Handle expired timers
-        auto now = Scheduler::Clock::now();
-        for (auto idx : scheduler_.popExpired(now)) {
-            if (fireTransition(idx, ""))
-                broadcastSnapshot();
-        }
+        const auto now = m_time->now();
+        dispatchPending(now);
+        flushSnapshot(now);
+    }
 
-        // Handle all queued inputs
-        while (true) {
-            std::pair<std::string,std::string> input;
-            {
-                std::unique_lock<std::mutex> lk2(m_mtx);
-                if (m_incoming.empty()) break;
-                input = std::move(m_incoming.front());
-                m_incoming.pop();
-            }
-            m_inputs[input.first] = input.second;
-            if (processImmediateTransitions(input.first))
-                broadcastSnapshot();
-        }
+    // Inputs injected before the stop request are still handled (and
+    // traced), e.g. the tail of a file fed on stdin
+    while (!m_incoming.empty()) {
+        dispatchPending(m_time->now());
+        if (processImmediateTransitions(""))
+            broadcastSnapshot();
     }
 }
+
+/**
+ * Starts the clock of the initial state and announces it, like run() does.
+ */
+void Automaton::start() {
+    // The initial state counts as entered now
+    m_stateSince = m_time->now();
+    if (m_recorder) m_recorder->write(TraceRecord::Kind::Start, m_stateSince);
+
+    // Send initial snapshot
+    broadcastSnapshot();
+}
+
+/**
+ * One non-blocking iteration of the run loop for externally driven automata.
+ */
+std::size_t Automaton::step(TimePoint now) {
+    if (m_stop) return 0;
+    const std::size_t handled = dispatchPending(now);
+
+    // Last, so the reached state's timers are armed before nextDeadline()
+    if (processImmediateTransitions(""))
+        broadcastSnapshot();
+    flushSnapshot(now);
+    return handled;
+}
+
+/**
+ * Virtual-time driver: step, jump to the next deadline, step again.
+ */
+std::size_t Automaton::fastForward(VirtualTime& clock, TimePoint until) {
+    if (m_time != &clock)
+        throw std::invalid_argument("fastForward: clock is not the automaton's time source");
+
+    std::size_t handled = step(clock.now());
+    while (!m_stop) {
+        const auto next = nextDeadline();
+        if (!next || *next > until) break;
+        clock.advanceTo(*next);
+        handled += step(clock.now());
+    }
+    clock.advanceTo(until);
+    return handled;
+}
+
+/**
+ * Fires the timers expired by @p now and applies queued inputs.
+ */
+std::size_t Automaton::dispatchPending(TimePoint now) {
+    std::size_t handled = 0;
+
+    // Handle expired timers
+    const auto expired = scheduler_.popExpired(now);
+    if (m_recorder && !expired.empty())
+        m_recorder->write(TraceRecord::Kind::Tick, now);
+    for (auto idx : expired) {
+        ++handled;
+        if (fireTransition(idx, ""))
+            broadcastSnapshot();
+    }
+
+    // Handle queued inputs in one batch, bounded so timers are not starved
+    handled += m_incoming.drain([&](InputEvent& input) {
+        if (input.kind == Injection::Kind::Keyframe) {
+            // Answered by the snapshot below; not an input, so not traced
+            m_keyframeDue = true;
+            m_changed = true;
+        }
+        else if (input.kind == Injection::Kind::Variable) {
+            if (m_recorder) m_recorder->write(TraceRecord::Kind::Variable, now, input.name, input.value);
+            setVariable(input.name, input.value);
+            m_changed = true;
+        }
+        else {
+            if (m_recorder) m_recorder->write(TraceRecord::Kind::Input, now, input.name, input.value);
+            SymbolId slot = m_inputs.set(input.name, input.value);
+            m_changed |= processImmediateTransitions(slot);
+        }
+        // A batch gets one snapshot, after its last entry
+        if (m_changed && !input.deferSnapshot) {
+            broadcastSnapshot();
+            m_changed = false;
+        }
+    }, m_incoming.capacity());
+    return handled;
+}
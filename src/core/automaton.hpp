@@ -13,16 +13,35 @@
 #include <vector>
 #include <string>
 #include <unordered_map>
+#include <atomic>
 #include <queue>
-#include <mutex>
-#include <condition_variable>
 #include <chrono>
+#include <thread>
+#include <optional>
 #include "scheduler.hpp"    // at the top
+#include "mpsc_queue.hpp"
+#include "mutex_queue.hpp"
+#include "parker.hpp"
 
+#include "symbol_table.hpp"
+#include "slots.hpp"
 #include "variable.hpp"
 #include "transition.hpp"
 #include "state.hpp"
+#include "compiled_fsm.hpp"
+#include "script_engine.hpp"
+#include "time_source.hpp"
+#include "trace.hpp"
 #include "io/channel.hpp" 
+#include "io/wire_format.hpp"
+#include "snapshot_record.hpp"
+
+/// 1 = lock-free MPSC ring as the input queue, 0 = mutex-guarded queue
+#ifndef FSM_LOCKFREE_INPUT_QUEUE
+#define FSM_LOCKFREE_INPUT_QUEUE 0
+#endif
+
+namespace io_bridge { class SnapshotSender; }
 
 namespace core_fsm {
 
@@ -68,6 +87,36 @@ public:
     };
 
     Automaton() = default;
+
+    /**
+     * @brief Create an automaton with a specific timer backend.
+     * @param timers  Storage for delayed transitions (heap or timing wheel).
+     */
+    explicit Automaton(Scheduler::Backend timers) : scheduler_(timers) {}
+
+    /**
+     * @brief Create an automaton with a specific timer backend and input queue size.
+     * @param timers         Storage for delayed transitions (heap or timing wheel).
+     * @param inputCapacity  Slots of the input queue; hosts running many
+     *                       automata use small queues to bound memory.
+     */
+    Automaton(Scheduler::Backend timers, std::size_t inputCapacity)
+        : scheduler_(timers), m_incoming(inputCapacity) {}
+
+    /**
+     * @brief Create an automaton running a model shared with other automata.
+     *
+     * Starts in the model's initial state with its initial variables; the
+     * model cannot be extended (addState() and addTransition() throw).
+     *
+     * @param model          Model frozen by share() or CompiledFsm::compile().
+     * @param timers         Storage for delayed transitions (heap or timing wheel).
+     * @param inputCapacity  Slots of the input queue.
+     */
+    Automaton(std::shared_ptr<const CompiledFsm> model,
+              Scheduler::Backend timers = Scheduler::Backend::Heap,
+              std::size_t inputCapacity = kInputQueueCapacity);
+
     ~Automaton() = default;
 
     Automaton(const Automaton&) = delete;
@@ -86,17 +135,55 @@ public:
     /** @brief Add an internal variable (by name). */
     void addVariable(const Variable& var);
 
-    /** @brief Add a state; if initial==true or first state, it becomes the start. */
+    /** @brief Declare an input port so its name is resolved to a slot up front. */
+    void addInput(const std::string& name);
+
+    /** @brief Declare an output port so its name is resolved to a slot up front. */
+    void addOutput(const std::string& name);
+
+    /**
+     * @brief Add a state; if initial==true or first state, it becomes the start.
+     * @throws std::logic_error if the model is already shared.
+     */
     void addState(const State& s, bool initial = false);
 
-    /** @brief Add a transition. */
+    /**
+     * @brief Add a transition.
+     * @throws std::logic_error if the model is already shared.
+     */
     void addTransition(const Transition& t);
 
+    /**
+     * @brief Build the per-state, per-trigger dispatch index.
+     *
+     * Resolves every trigger name to its input slot, every delay variable to
+     * its variable slot, binds native guards and actions to the slots, and
+     * groups transition indices by source state (CSR layout), sorted by
+     * trigger id inside each state.  Call it once the model is complete;
+     * it is also rebuilt lazily on the next dispatch if states or
+     * transitions were added afterwards.
+     */
+    void buildDispatchIndex();
+
+    /**
+     * @brief Freeze the model so other automata can run it.
+     *
+     * Builds the dispatch index if needed and records the current slot
+     * layout and variable values as the model's initial ones, so call it
+     * before start().  The automaton keeps running on the frozen model;
+     * pass the result to Automaton(model, ...) or FsmInstance.
+     *
+     * @return The shared, immutable model.
+     */
+    std::shared_ptr<const CompiledFsm> share();
+
     /**
      * @brief Sends current state snapshot to connected channels
      * 
      * Broadcasts the current state, variables, inputs, and outputs through
-     * the connected communication channel, if available.
+     * the connected communication channel, if available.  Counts as one
+     * event; the publish policy decides whether it is sent now, later or
+     * not at all.
      */
     void broadcastSnapshot();
 
@@ -117,16 +204,208 @@ public:
      */
     bool processImmediateTransitions(const std::string& trigger);
 
-    /** @brief Called by external code/threads to inject an input event. */
+    /**
+     * @brief Same as above, with the trigger already resolved to its input slot.
+     * @param trigger Input slot id of the trigger (kNoSymbol matches nothing)
+     * @return true if any transition was fired, false otherwise
+     */
+    bool processImmediateTransitions(SymbolId trigger);
+
+    /**
+     * @brief Fire undelayed transitions synchronously instead of via 1 ms timers.
+     *
+     * In run-to-completion mode an input (or a state entry) that enables a
+     * transition without delay changes the state within the same step, and
+     * undelayed unconditional transitions of the reached states follow as
+     * microsteps.  Delayed transitions are unaffected.
+     *
+     * @param enabled        True to enable run-to-completion.
+     * @param maxMicrosteps  Microsteps per step before the rest is deferred
+     *                       to the scheduler (livelock guard).
+     */
+    void setRunToCompletion(bool enabled, std::size_t maxMicrosteps = 64) noexcept {
+        m_runToCompletion = enabled;
+        m_maxMicrosteps   = maxMicrosteps;
+    }
+
+    /** @return True if undelayed transitions fire within the step. */
+    bool runToCompletion() const noexcept { return m_runToCompletion; }
+
+    /** @return Microstep bound per step (see setRunToCompletion()). */
+    std::size_t maxMicrosteps() const noexcept { return m_maxMicrosteps; }
+
+    /**
+     * @brief Called by external code/threads to inject an input event.
+     *
+     * Lock-free; if the input queue is full the caller yields until the
+     * run loop has made room, so no input is dropped.
+     */
     void injectInput(const std::string& name,
                      const std::string& value);
 
-    /** @brief Ask the `run()` loop to exit at the next opportunity. */
+    /**
+     * @struct Injection
+     * @brief One entry of a batch passed to injectBatch().
+     */
+    struct Injection {
+        /// What the entry updates.
+        enum class Kind : std::uint8_t {
+            Input,    ///< Like injectInput()
+            Variable, ///< Like setVariable()
+            Keyframe  ///< Like requestKeyframe() (name and value unused)
+        };
+        Kind        kind{Kind::Input}; ///< Entry type
+        std::string name;              ///< Input or variable name
+        std::string value;             ///< New value
+    };
+
+    /**
+     * @brief Inject a batch of input/variable updates as one unit.
+     *
+     * The entries are enqueued in one go (no other producer's events
+     * interleave with them, unless the batch exceeds the input queue
+     * capacity and has to be split) and are applied by the run loop in
+     * order.  Each input dispatches its transitions as usual, but a single
+     * snapshot is broadcast once the whole batch has been applied.
+     *
+     * @param entries  First entry.
+     * @param count    Number of entries.
+     */
+    void injectBatch(const Injection* entries, std::size_t count);
+
+    /** @brief Same as above for a vector of entries. */
+    void injectBatch(const std::vector<Injection>& entries) {
+        injectBatch(entries.data(), entries.size());
+    }
+
+    /**
+     * @brief Inject several inputs as one batch (see injectBatch()).
+     * @param inputs  (name, value) pairs, applied in order.
+     */
+    void injectInputs(const std::vector<std::pair<std::string, std::string>>& inputs);
+
+    /**
+     * @brief Ask the `run()` loop to exit at the next opportunity.
+     *
+     * Inputs injected before the call are still dispatched; timers that
+     * are not yet due are dropped.
+     */
     void requestStop() noexcept;
 
-    /** @brief Blocking interpreter loop; returns when `requestStop()` is called. */
+    /**
+     * @brief Blocking interpreter loop; returns when `requestStop()` is
+     *        called and the input queue has been drained.
+     */
     void run();
 
+    /// Driving from an external loop --------------------------------------
+
+    /**
+     * @brief Route wakeups to @p fn instead of the run() loop.
+     *
+     * Used when the automaton is driven by step() from a host: @p fn is
+     * called (from the injecting thread) whenever an input is queued or a
+     * stop is requested, and should schedule a step().  Set it before
+     * inputs can arrive.
+     */
+    void setWakeHandler(std::function<void()> fn) { m_wakeHandler = std::move(fn); }
+
+    /**
+     * @brief Called, instead of waking and yielding, while an injection
+     *        finds the input queue full.
+     *
+     * A driver whose thread both injects and steps has to drain the queue
+     * here (e.g. by stepping the automaton), or the injection never ends.
+     */
+    void setFullHandler(std::function<void()> fn) { m_fullHandler = std::move(fn); }
+
+    /**
+     * @brief Enter the initial state: start its clock and broadcast it.
+     *
+     * The step() counterpart of what run() does on entry; call it once,
+     * from the thread that will step the automaton.
+     */
+    void start();
+
+    /**
+     * @brief Do whatever is due without blocking.
+     *
+     * Fires expired timers, the queued inputs and then undelayed
+     * transitions (arming the timers of the state reached), like one
+     * iteration of run().  Only one thread may step an automaton at a time.
+     *
+     * @return Number of inputs and timers handled.
+     */
+    std::size_t step() { return step(m_time->now()); }
+
+    /**
+     * @brief step() with the time taken by the caller.
+     *
+     * Lets a loop stepping many automata read the clock once per round.
+     *
+     * @param now  Current time; timers due by then fire.
+     * @return     Number of inputs and timers handled.
+     */
+    std::size_t step(TimePoint now);
+
+    /**
+     * @brief Check, without blocking, whether step() has work.
+     * @param now  Current time.
+     * @return     True if inputs are queued or a timer is due by @p now.
+     */
+    bool pollReady(TimePoint now) {
+        if (!m_incoming.empty()) return true;
+        const auto at = nextDeadline();
+        return at && *at <= now;
+    }
+
+    /** @return When step() next has timer (or trailing snapshot) work to do, if ever. */
+    std::optional<TimePoint> nextDeadline() {
+        auto at = scheduler_.nextExpiry();
+        if (m_flushAt && (!at || *m_flushAt < *at)) at = m_flushAt;
+        return at;
+    }
+
+    /// Time ---------------------------------------------------------------
+
+    /**
+     * @brief Read time from @p time instead of steady_clock.
+     *
+     * Timers, state entry times, the event log and elapsed() in actions all
+     * follow it.  Set it before start(); @p time must outlive the automaton.
+     */
+    void setTimeSource(const TimeSource& time) noexcept { m_time = &time; }
+
+    /** @return The time source in use. */
+    const TimeSource& timeSource() const noexcept { return *m_time; }
+
+    /**
+     * @brief Simulate up to @p until by jumping from deadline to deadline.
+     *
+     * Steps at the current virtual time, then repeatedly advances @p clock
+     * to the next timer deadline and steps again, so timed behaviour runs
+     * as fast as the transitions execute; the sequence is the one real
+     * time would produce.  Call start() first.
+     *
+     * @param clock  The automaton's time source (see setTimeSource()).
+     * @param until  Where virtual time stops.
+     * @return       Number of inputs and timers handled.
+     * @throws std::invalid_argument if @p clock is not the time source.
+     */
+    std::size_t fastForward(VirtualTime& clock, TimePoint until);
+
+    /**
+     * @brief Record every consumed input, timer step and state entry.
+     *
+     * Records are written from the thread that runs or steps the automaton;
+     * see replayTrace().  Set it before start(); @p trace must outlive the
+     * automaton, or be reset to null first.
+     */
+    void setRecorder(TraceWriter* trace) noexcept { m_recorder = trace; }
+
+    /** @return True once requestStop() has been called. */
+    bool stopRequested() const noexcept { return m_stop.load(std::memory_order_acquire); }
+
     /// Inspection -----------------------------------------------------------
 
     /** @return The name of the current active state. */
@@ -143,41 +422,181 @@ public:
         m_channel = std::move(ch);
     }
 
+    /**
+     * @brief Publish snapshots through @p sender's I/O thread instead of
+     *        encoding and sending them inline (set before start()).
+     *
+     * The automaton only copies the changed entries into the sender's ring.
+     * When the ring is full the snapshot is dropped, never waited for; its
+     * changes go out with the next one, and with Overflow::Coalesce that is
+     * retried shortly even if no further event comes.
+     */
+    void attachSender(std::shared_ptr<io_bridge::SnapshotSender> sender) {
+        m_sender = std::move(sender);
+    }
+
+    /**
+     * @brief Broadcast only what changed since the previous snapshot.
+     *
+     * A `"delta"` message carries the state plus the inputs, variables and
+     * outputs changed since the message before it (an input that became
+     * unset is sent as null).  Every @p keyframeEvery messages, the first
+     * one and on requestKeyframe() a full `"state"` message is sent instead.
+     * Set it before start().
+     *
+     * @param keyframeEvery  Messages per keyframe; 0 sends every snapshot in full.
+     */
+    void setDeltaSnapshots(std::size_t keyframeEvery) noexcept { m_keyframeEvery = keyframeEvery; }
+
+    /**
+     * @struct PublishPolicy
+     * @brief When a snapshot is worth sending.
+     *
+     * Every fired transition and processed input is an event and takes a
+     * sequence number; events whose snapshot is not sent leave a gap, so
+     * `seq` still tells a consumer how many were coalesced.
+     */
+    struct PublishPolicy {
+        enum class Mode : std::uint8_t {
+            EveryEvent,     ///< One snapshot per event (the default)
+            OnStateChange,  ///< Only when the active state differs from the last one sent
+            Interval        ///< At most one per interval, the last event flushed when it ends
+        };
+        Mode                      mode{Mode::EveryEvent};
+        std::chrono::milliseconds interval{0};  ///< Minimum gap (Interval)
+
+        static PublishPolicy everyEvent() noexcept { return {}; }
+        static PublishPolicy onStateChange() noexcept { return {Mode::OnStateChange, {}}; }
+        static PublishPolicy atMostEvery(std::chrono::milliseconds gap) noexcept {
+            return {Mode::Interval, gap};
+        }
+    };
+
+    /**
+     * @brief Choose which events are published (set before start()).
+     *
+     * The first snapshot and requested keyframes are always sent.  With
+     * Interval, the trailing snapshot is due at nextDeadline().
+     */
+    void setPublishPolicy(const PublishPolicy& policy) noexcept { m_policy = policy; }
+
+    /**
+     * @brief Broadcast a full snapshot soon (e.g. a client missed a delta).
+     *
+     * Queued like an input, so it is sent from the run loop; any thread.
+     */
+    void requestKeyframe();
+
+    /**
+     * @brief Encode snapshots as @p format from the next one on (any thread).
+     *
+     * Set by the runtime when a client's `hello` picks a binary format;
+     * JSON is the default.
+     */
+    void setWireFormat(io_bridge::WireFormat format) noexcept {
+        m_wireFormat.store(format, std::memory_order_relaxed);
+    }
+
+    /** @return Encoding of the snapshots. */
+    io_bridge::WireFormat wireFormat() const noexcept {
+        return m_wireFormat.load(std::memory_order_relaxed);
+    }
+
 public:
-    /// Current registered inputs (name → last‐seen value)
-    const std::unordered_map<std::string, std::string>& inputs() const noexcept {
+    /// Current registered inputs (slot → last‐seen value)
+    const IOSlots& inputs() const noexcept {
         return m_inputs;
     }
 
-    /// Current variables (name → Variable)
-    const std::unordered_map<std::string, Variable>& vars() const noexcept {
+    /// Current variables (slot → type and value)
+    const VarSlots& vars() const noexcept {
         return m_vars;
     }
 
-    /// Current outputs (name → last‐emitted value)
-    const std::unordered_map<std::string, std::string>& outputs() const noexcept {
+    /// Current outputs (slot → last‐emitted value)
+    const IOSlots& outputs() const noexcept {
         return m_outputs;
     }
     
     
 private:
+    /// Slots of the input queue (inputs waiting for the run loop)
+    static constexpr std::size_t kInputQueueCapacity = 4096;
+
+    /// One queued input; slot buffers are reused between events
+    struct InputEvent {
+        std::string     name;
+        std::string     value;
+        Injection::Kind kind{Injection::Kind::Input};
+        bool            deferSnapshot{false}; // Batch continues after this entry
+    };
+
+    /// Input queue: the mutex one unless the lock-free ring is selected
+#if FSM_LOCKFREE_INPUT_QUEUE
+    using InputQueue = MpscRing<InputEvent>;
+#else
+    using InputQueue = MutexQueue<InputEvent>;
+#endif
+
+    /// Enqueue @p count events as one run; @p fill(i, ev) writes event @p i
+    template<typename Fill>
+    void enqueueBatch(std::size_t count, Fill&& fill);
+
+    /// Wake whoever consumes the input queue
+    void wake() {
+        if (m_wakeHandler) m_wakeHandler();
+        else               m_wakeup.unpark();
+    }
+
+    /// The input queue is full: get it drained before the producer retries
+    void waitForRoom() {
+        if (m_fullHandler) {
+            m_fullHandler();
+            return;
+        }
+        wake();
+        std::this_thread::yield();
+    }
+
+    /// Fire expired timers and drain the input queue; returns events handled
+    std::size_t dispatchPending(TimePoint now);
+
+    /// Encode and send (or queue) the snapshot for event m_seq, ignoring the policy
+    void sendSnapshot();
+
+    /// Copy the state and the entries a snapshot carries into @p r
+    void fillSnapshot(SnapshotRecord& r, bool key, TimePoint now) const;
+
+    /// Send the snapshot held back by the Interval policy once it is due
+    void flushSnapshot(TimePoint now) {
+        if (m_flushAt && now >= *m_flushAt) sendSnapshot();
+    }
+
     Scheduler scheduler_;           // Scheduler for time-based transitions
     SnapshotFn m_snapshotHook;      // Callback for state changes
 
     // For scheduling delayed transitions:
     struct Pending {
         TimePoint   due;            // When the transition should fire
-        std::size_t transitionIndex;// Index into m_transitions
+        std::size_t transitionIndex;// Index into the model's transitions
         bool operator>(Pending const& o) const { return due > o.due; }
     };
 
-    std::vector<State>           m_states;       // All defined states
-    std::vector<Transition>      m_transitions;  // All defined transitions
+    // States, transitions and the dispatch index; m_draft is set while this
+    // automaton still builds the model, m_model always points to it
+    std::shared_ptr<CompiledFsm>       m_draft{new CompiledFsm};
+    std::shared_ptr<const CompiledFsm> m_model{m_draft};
     std::size_t                  m_active{0};    // Index of current active state
+    bool                         m_dispatchDirty{true}; // Rebuild before next dispatch
+
+    // Run-to-completion
+    bool                         m_runToCompletion{false}; // Fire undelayed transitions in-step
+    std::size_t                  m_maxMicrosteps{64};      // Livelock guard per step
+    bool                         m_livelockReported{false}; // Warned about the guard once
 
     // Last‐known values
-    std::unordered_map<std::string, Variable>    m_vars;    // Variables and their values
-    std::unordered_map<std::string, std::string> m_inputs;  // Input values
+    VarSlots                                      m_vars;    // Variables and their values
+    IOSlots                                       m_inputs;  // Input values (slots double as trigger ids)
 
     // Timers for delayed transitions
     std::priority_queue<
@@ -187,19 +606,47 @@ private:
     >                                             m_timers;  // Ordered by due time
 
     // Input injection & stop signalling
-    std::mutex                                    m_mtx;     // Protects the queue
-    std::condition_variable                       m_cv;      // For run loop wakeup
-    std::queue<std::pair<std::string,std::string>> m_incoming;// Input queue
-    bool                                          m_stop{false}; // Stop flag
+    InputQueue                                    m_incoming{kInputQueueCapacity}; // Input queue
+    Parker                                        m_wakeup;  // Parks the idle run loop
+    std::function<void()>                         m_wakeHandler; // Replaces m_wakeup when hosted
+    std::function<void()>                         m_fullHandler; // Drains a full queue (see setFullHandler())
+    const TimeSource*                             m_time{&TimeSource::steady()}; // Clock of timers and logs
+    TraceWriter*                                  m_recorder{nullptr}; // Input trace (see setRecorder())
+    bool                                          m_changed{false}; // Unsent changes (spans a batch)
+    std::atomic<bool>                             m_stop{false}; // Stop flag
 
     // History of entries
     std::vector<EventLog>                         m_log;     // State entry log
 
-    std::unordered_map<std::string,std::string> m_outputs;    // last‐known outputs
+    IOSlots                                      m_outputs;    // last‐known outputs
     std::chrono::steady_clock::time_point        m_stateSince; // when we last entered m_active
+
+    // Persistent JS mirrors of the slots, synced incrementally
+    script::JsContext       m_guardJs{script::Dialect::Guard};   // For JS guards
+    script::JsContext       m_actionJs{script::Dialect::Action}; // For JS entry actions
   
     io_bridge::ChannelPtr   m_channel;           // Communication channel
     uint64_t                m_seq{0};            // Sequence counter for messages
+
+    // Delta snapshots (see setDeltaSnapshots())
+    std::size_t             m_keyframeEvery{0};  // 0 = full snapshots only
+    std::size_t             m_sinceKeyframe{0};  // Deltas sent since the last keyframe
+    bool                    m_keyframeDue{true}; // Next snapshot is a keyframe
+    std::uint64_t           m_sentInputs{0};     // Slot generations covered by the last message
+    std::uint64_t           m_sentVars{0};
+    std::uint64_t           m_sentOutputs{0};
+
+    // Publish policy (see setPublishPolicy())
+    PublishPolicy           m_policy;
+    std::size_t             m_publishedState{static_cast<std::size_t>(-1)}; // State of the last snapshot sent
+    uint64_t                m_publishedSeq{0};   // Seq of the last snapshot sent
+    TimePoint               m_publishedAt{};     // When it was sent
+    std::optional<TimePoint> m_flushAt;          // Trailing snapshot due (Interval)
+
+    std::atomic<io_bridge::WireFormat> m_wireFormat{io_bridge::WireFormat::Json}; // Snapshot encoding
+    std::shared_ptr<io_bridge::SnapshotSender> m_sender; // I/O thread, if snapshots are offloaded
+    SnapshotRecord          m_record;            // Inline snapshot (buffers reused)
+    io_bridge::Packet       m_outgoing;          // Encoded snapshot (buffer reused)
 };
 
 } // namespace core_fsm
\ No newline at end of file
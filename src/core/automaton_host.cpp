@@ -0,0 +1,156 @@
+/**
+ * @file   automaton_host.cpp
+ * @brief  Implements AutomatonHost: pool-driven stepping of many automata
+ *         and the shared wakeup timer thread.
+ *
+ * @author Martin Ševčík (xsevcim00)
+ * @author Jakub Lůčný (xlucnyj00)
+ * @date   2025-05-06
+ */
+
+#include "automaton_host.hpp"
+
+namespace core_fsm {
+
+AutomatonHost::AutomatonHost(std::size_t workers)
+: m_pool(workers, [this](std::size_t id, std::size_t worker) { runStep(id, worker); })
+{
+    m_stats.reserve(m_pool.workers());
+    for (std::size_t i = 0; i < m_pool.workers(); ++i)
+        m_stats.push_back(std::make_unique<Counters>());
+}
+
+AutomatonHost::~AutomatonHost() {
+    stop();
+}
+
+// Adopt an automaton and route its wakeups to the pool
+std::size_t AutomatonHost::add(std::unique_ptr<Automaton> fsm) {
+    const std::size_t id = m_slots.size();
+    fsm->setWakeHandler([this, id] { schedule(id); });
+    auto slot = std::make_unique<Slot>();
+    slot->fsm = std::move(fsm);
+    m_slots.push_back(std::move(slot));
+    return id;
+}
+
+// Start the timer thread and give every automaton its first step
+void AutomatonHost::start() {
+    m_timerThread = std::thread([this] { timerLoop(); });
+    for (std::size_t id = 0; id < m_slots.size(); ++id)
+        schedule(id);
+}
+
+// Stop the timer thread, then the workers
+void AutomatonHost::stop() {
+    if (m_stopping.exchange(true)) return;
+    {
+        std::lock_guard<std::mutex> lk(m_timerMtx);
+        m_timerCv.notify_one();
+    }
+    if (m_timerThread.joinable()) m_timerThread.join();
+    m_pool.stop();
+}
+
+// Snapshot the per-worker counters
+std::vector<AutomatonHost::WorkerStats> AutomatonHost::stats() const {
+    std::vector<WorkerStats> out;
+    out.reserve(m_stats.size());
+    for (const auto& c : m_stats) {
+        WorkerStats s;
+        s.steps  = c->steps.load(std::memory_order_relaxed);
+        s.events = c->events.load(std::memory_order_relaxed);
+        s.busy   = std::chrono::nanoseconds(c->busyNs.load(std::memory_order_relaxed));
+        out.push_back(s);
+    }
+    return out;
+}
+
+/**
+ * Queue automaton @p id unless it is queued already; if it is being
+ * stepped, make the worker step it once more.  Every path is a
+ * read-modify-write so the next step synchronizes with the producer that
+ * queued the input.
+ */
+void AutomatonHost::schedule(std::size_t id) {
+    if (m_stopping.load(std::memory_order_acquire)) return;
+    Slot& s = *m_slots[id];
+    std::uint8_t st = s.state.load(std::memory_order_relaxed);
+    for (;;) {
+        std::uint8_t next = st;
+        if (st == kIdle)         next = kQueued;
+        else if (st == kRunning) next = kRerun;
+        if (s.state.compare_exchange_weak(st, next, std::memory_order_acq_rel)) {
+            if (st == kIdle) m_pool.submit(id);
+            return;
+        }
+    }
+}
+
+// Worker side: step the automaton, re-arm its wakeup, requeue if woken meanwhile
+void AutomatonHost::runStep(std::size_t id, std::size_t worker) {
+    Slot& s = *m_slots[id];
+    s.state.exchange(kRunning, std::memory_order_acq_rel);
+
+    Automaton& fsm = *s.fsm;
+    const auto t0 = Scheduler::Clock::now();
+    if (!s.started) {
+        fsm.start();
+        s.started = true;
+    }
+    const std::size_t handled = fsm.step();
+    const auto t1 = Scheduler::Clock::now();
+
+    Counters& c = *m_stats[worker];
+    c.steps.fetch_add(1, std::memory_order_relaxed);
+    c.events.fetch_add(handled, std::memory_order_relaxed);
+    c.busyNs.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count(),
+                       std::memory_order_relaxed);
+
+    // Most steps leave the deadline as it was: skip the shared timer then
+    const auto deadline = fsm.nextDeadline();
+    if (deadline != s.armed) {
+        armTimer(id, deadline);
+        s.armed = deadline;
+    }
+
+    std::uint8_t st = kRunning;
+    if (!s.state.compare_exchange_strong(st, kIdle, std::memory_order_acq_rel)) {
+        // kRerun: an input arrived during the step
+        s.state.store(kQueued, std::memory_order_release);
+        m_pool.submit(id);
+    }
+}
+
+/**
+ * Make the timer thread wake automaton @p id at @p at.  Without a deadline
+ * an older wakeup may still fire; the resulting step is simply empty.
+ */
+void AutomatonHost::armTimer(std::size_t id, std::optional<Scheduler::TimePoint> at) {
+    if (!at) return;
+    std::lock_guard<std::mutex> lk(m_timerMtx);
+    m_timers.armAt(id, *at);
+    if (*at < m_timerWakeAt)
+        m_timerCv.notify_one();
+}
+
+// Sleep until the earliest wakeup, then queue every automaton that is due
+void AutomatonHost::timerLoop() {
+    std::vector<std::size_t> due;
+    std::unique_lock<std::mutex> lk(m_timerMtx);
+    while (!m_stopping.load(std::memory_order_acquire)) {
+        auto next = m_timers.nextExpiry();
+        m_timerWakeAt = next.value_or(Scheduler::TimePoint::max());
+        if (next) m_timerCv.wait_until(lk, *next);
+        else      m_timerCv.wait(lk);
+        if (m_stopping.load(std::memory_order_acquire)) break;
+
+        due = m_timers.popExpired(Scheduler::Clock::now());
+        if (due.empty()) continue;
+        lk.unlock();
+        for (std::size_t id : due) schedule(id);
+        lk.lock();
+    }
+}
+
+} // namespace core_fsm
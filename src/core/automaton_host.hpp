@@ -0,0 +1,129 @@
+/**
+ * @file   automaton_host.hpp
+ * @brief  Runs many automata in one process on a shared worker pool.
+ *
+ * Instead of one blocking run() thread per automaton, each hosted
+ * automaton is stepped by a WorkStealingPool whenever it has inputs
+ * queued or a timer due.  Automata keep their own input queue and
+ * scheduler; the host only keeps one wakeup timer per automaton.
+ *
+ * @author Martin Ševčík (xsevcim00)
+ * @author Jakub Lůčný (xlucnyj00)
+ * @date   2025-05-06
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+#include "automaton.hpp"
+#include "scheduler.hpp"
+#include "work_stealing_pool.hpp"
+
+namespace core_fsm {
+
+/**
+ * @class AutomatonHost
+ * @brief Schedules step() of many automata on a fixed-size thread pool.
+ *
+ * An automaton is queued on the pool when an input arrives (through its
+ * wake handler) or when its next timer deadline passes.  A per-automaton
+ * state word guarantees it is stepped by one worker at a time and that a
+ * wakeup arriving mid-step triggers another step.
+ */
+class AutomatonHost {
+public:
+    /// Work done by one worker since start().
+    struct WorkerStats {
+        std::uint64_t            steps{0};  ///< step() calls
+        std::uint64_t            events{0}; ///< Inputs and timers handled
+        std::chrono::nanoseconds busy{0};   ///< Time spent inside step()
+    };
+
+    /**
+     * @brief Create a host.
+     * @param workers  Pool size; typically the number of cores.
+     */
+    explicit AutomatonHost(std::size_t workers);
+
+    /** @brief Stops the pool and timer thread. */
+    ~AutomatonHost();
+
+    AutomatonHost(const AutomatonHost&) = delete;
+    AutomatonHost& operator=(const AutomatonHost&) = delete;
+
+    /**
+     * @brief Take ownership of a fully built automaton (before start()).
+     * @param fsm  The automaton; its wake handler is replaced by the host.
+     * @return     Id of the automaton within the host.
+     */
+    std::size_t add(std::unique_ptr<Automaton> fsm);
+
+    /** @return Number of hosted automata. */
+    std::size_t size() const noexcept { return m_slots.size(); }
+
+    /** @return Hosted automaton @p id (inject inputs through it). */
+    Automaton& automaton(std::size_t id) { return *m_slots[id]->fsm; }
+
+    /** @return Number of pool workers. */
+    std::size_t workers() const noexcept { return m_stats.size(); }
+
+    /** @brief Start the timer thread and enter every automaton's initial state. */
+    void start();
+
+    /** @brief Stop stepping; pending inputs and timers are abandoned. */
+    void stop();
+
+    /** @return Counters of every worker. */
+    std::vector<WorkerStats> stats() const;
+
+private:
+    /// Scheduling state of one automaton
+    enum : std::uint8_t {
+        kIdle,     ///< Not queued
+        kQueued,   ///< Waiting in the pool
+        kRunning,  ///< Being stepped
+        kRerun     ///< Being stepped, and woken again meanwhile
+    };
+
+    struct Slot {
+        std::unique_ptr<Automaton> fsm;
+        std::atomic<std::uint8_t>  state{kIdle};
+        bool                       started{false}; ///< start() done (worker only)
+        std::optional<Scheduler::TimePoint> armed; ///< Wakeup last armed (worker only)
+    };
+
+    /// Per-worker counters, on their own cache line
+    struct alignas(64) Counters {
+        std::atomic<std::uint64_t> steps{0};
+        std::atomic<std::uint64_t> events{0};
+        std::atomic<std::int64_t>  busyNs{0};
+    };
+
+    void schedule(std::size_t id);
+    void runStep(std::size_t id, std::size_t worker);
+    void armTimer(std::size_t id, std::optional<Scheduler::TimePoint> at);
+    void timerLoop();
+
+    std::vector<std::unique_ptr<Slot>>     m_slots;   // Hosted automata
+    std::vector<std::unique_ptr<Counters>> m_stats;   // Per worker
+
+    // Wakeup timers: one per automaton (its next deadline)
+    std::mutex                m_timerMtx;
+    std::condition_variable   m_timerCv;
+    Scheduler                 m_timers{Scheduler::Backend::Wheel};
+    Scheduler::TimePoint      m_timerWakeAt{Scheduler::TimePoint::max()};
+    std::thread               m_timerThread;
+
+    std::atomic<bool>         m_stopping{false};
+    WorkStealingPool          m_pool;             // Last: its workers use the above
+};
+
+} // namespace core_fsm
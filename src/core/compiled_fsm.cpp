@@ -0,0 +1,26 @@
+/**
+ * @file   compiled_fsm.cpp
+ * @brief  Implements CompiledFsm: extraction of the shared model from a
+ *         built Automaton.
+ *
+ * @author Martin Ševčík (xsevcim00)
+ * @author Jakub Lůčný (xlucnyj00)
+ * @date   2025-05-06
+ */
+
+#include "compiled_fsm.hpp"
+#include "automaton.hpp"
+
+namespace core_fsm {
+
+/**
+ * The automaton already keeps its states, transitions and dispatch index
+ * in a CompiledFsm; freezing it binds the native programs and records the
+ * slot layout, so the model never changes after this call.
+ */
+std::shared_ptr<const CompiledFsm> CompiledFsm::compile(Automaton&& built)
+{
+    return built.share();
+}
+
+} // namespace core_fsm
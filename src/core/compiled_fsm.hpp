@@ -0,0 +1,108 @@
+/**
+ * @file   compiled_fsm.hpp
+ * @brief  Declares CompiledFsm, the immutable part of an automaton (states,
+ *         transitions, dispatch index, slot layout) shared by any number of
+ *         Automaton or lightweight FsmInstance objects.
+ *
+ * @author Martin Ševčík (xsevcim00)
+ * @author Jakub Lůčný (xlucnyj00)
+ * @date   2025-05-06
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "slots.hpp"
+#include "state.hpp"
+#include "transition.hpp"
+
+namespace core_fsm {
+
+class Automaton;
+
+/**
+ * @class CompiledFsm
+ * @brief Read-only model built once and shared by its instances.
+ *
+ * Every Automaton builds its model into a CompiledFsm; Automaton::share()
+ * (or compile()) freezes it.  Native guards and actions are bound to the
+ * slot layout at that point, so nothing in the model is written while
+ * instances run.  The slot templates hold the declared names (shared
+ * copy-on-write with every instance) and the initial variable values.
+ */
+class CompiledFsm {
+public:
+    /// One outgoing transition of a state, keyed by its trigger slot.
+    struct DispatchEntry {
+        SymbolId      trigger;    ///< Input slot of the trigger
+        std::uint32_t transition; ///< Index into transitions()
+    };
+
+    /**
+     * @brief Freeze the model of a built automaton.
+     *
+     * @param built  Automaton that has all states, transitions, variables
+     *               and ports added; it keeps running on the shared model.
+     * @return       The shared, immutable model (see Automaton::share()).
+     */
+    static std::shared_ptr<const CompiledFsm> compile(Automaton&& built);
+
+    /** @return All states. */
+    const std::vector<State>& states() const noexcept { return m_states; }
+
+    /** @return All transitions. */
+    const std::vector<Transition>& transitions() const noexcept { return m_transitions; }
+
+    /** @return Index of the initial state. */
+    std::size_t initialState() const noexcept { return m_initial; }
+
+    /** @return Dispatch entries of state @p s, ordered by trigger. */
+    const DispatchEntry* rowBegin(std::size_t s) const noexcept { return m_dispatch.data() + m_dispatchStart[s]; }
+
+    /** @return One past the last dispatch entry of state @p s. */
+    const DispatchEntry* rowEnd(std::size_t s) const noexcept { return m_dispatch.data() + m_dispatchStart[s + 1]; }
+
+    /** @return Variable slot holding the delay of transition @p i, or kNoSymbol. */
+    SymbolId delayVar(std::size_t i) const noexcept { return m_delayVar[i]; }
+
+    /** @return Trigger slot of unconditional transitions (kNoSymbol if none). */
+    SymbolId unconditional() const noexcept { return m_unconditional; }
+
+    /** @return Variable layout with the initial values. */
+    const VarSlots& initialVars() const noexcept { return m_vars; }
+
+    /** @return Declared inputs, all unset. */
+    const IOSlots& inputLayout() const noexcept { return m_inputs; }
+
+    /** @return Declared outputs, all unset. */
+    const IOSlots& outputLayout() const noexcept { return m_outputs; }
+
+    /** @return True if undelayed transitions fire within the step. */
+    bool runToCompletion() const noexcept { return m_runToCompletion; }
+
+    /** @return Microstep bound per step (livelock guard). */
+    std::size_t maxMicrosteps() const noexcept { return m_maxMicrosteps; }
+
+private:
+    friend class Automaton;     // Builds the model in place
+
+    CompiledFsm() = default;
+
+    std::vector<State>          m_states;
+    std::vector<Transition>     m_transitions;
+    std::size_t                 m_initial{0};
+    std::vector<SymbolId>       m_delayVar;      // Delay variable slot per transition
+    std::vector<std::uint32_t>  m_dispatchStart; // Row offsets, size = states + 1
+    std::vector<DispatchEntry>  m_dispatch;      // Candidates grouped by source state
+    SymbolId                    m_unconditional{kNoSymbol};
+    VarSlots                    m_vars;          // Layout + initial values
+    IOSlots                     m_inputs;        // Declared inputs
+    IOSlots                     m_outputs;       // Declared outputs
+    bool                        m_runToCompletion{false};
+    std::size_t                 m_maxMicrosteps{64};
+};
+
+} // namespace core_fsm
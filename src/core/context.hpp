@@ -1,7 +1,7 @@
 /**
  * @file   context.hpp
  * @brief  Defines the Context struct, which wraps references to the
- *         Automaton’s variable, input, and output maps plus timing info,
+ *         Automaton’s variable, input, and output slots plus timing info,
  *         and provides helper methods for FSM actions.
  *
  * @author Martin Ševčík (xsevcim00)
@@ -11,26 +11,28 @@
 
 #pragma once
 
-#include <unordered_map>
 #include <string>
 #include <variant>
 #include <chrono>
 #include <stdexcept>
 #include "variable.hpp"     ///< for core_fsm::Value
+#include "slots.hpp"
 
 namespace core_fsm {
 
+namespace script { class JsContext; }
+
 /**
  * @typedef VarMap
- * @brief  Map from variable names to Variable objects.
+ * @brief  Slot-indexed storage of the automaton's variables.
  */
-using VarMap = std::unordered_map<std::string, Variable>;
+using VarMap = VarSlots;
 
 /**
  * @typedef IOMap
- * @brief  Map from input/output names to their last-seen string values.
+ * @brief  Slot-indexed storage of input/output names and their last-seen values.
  */
-using IOMap  = std::unordered_map<std::string, std::string>;
+using IOMap  = IOSlots;
 
 /**
  * @typedef Clock
@@ -42,41 +44,109 @@ using Clock  = std::chrono::steady_clock;
  * @struct Context
  * @brief  Runtime context passed into state entry and transition guards.
  *
- * Holds references into the Automaton’s internal maps of variables,
+ * Holds references into the Automaton’s slot storage of variables,
  * inputs, and outputs, plus the timestamp when the current state was entered.
+ * Every accessor exists in two flavours: by name (hashes the name on each
+ * call) and by SymbolId (resolved once via varId()/inputId()/outputId()).
  */
 struct Context {
     VarMap&  vars;         ///< Reference to Automaton::m_vars
     IOMap&   inputs;       ///< Reference to Automaton::m_inputs
     IOMap&   outputs;      ///< Reference to Automaton::m_outputs
     Clock::time_point stateSince; ///< Time point when current state was entered
+    Clock::time_point now;        ///< Owner's current time (its TimeSource) for the action
+    script::JsContext* script;    ///< Persistent JS mirror of the slots (may be null)
 
     /**
-     * @brief Construct a Context binding to the real FSM maps.
-     * @param vars_       Reference to the variable map.
-     * @param inputs_     Reference to the input map.
-     * @param outputs_    Reference to the output map.
+     * @brief Construct a Context binding to the real FSM storage.
+     * @param vars_       Reference to the variable slots.
+     * @param inputs_     Reference to the input slots.
+     * @param outputs_    Reference to the output slots.
      * @param since_      Timestamp of state entry.
+     * @param now_        Current time of the owner's time source.
+     * @param script_     Owner's JS mirror used by script actions, if any.
      */
     Context(VarMap& vars_,
             IOMap& inputs_,
             IOMap& outputs_,
-            Clock::time_point since_)
+            Clock::time_point since_,
+            Clock::time_point now_,
+            script::JsContext* script_ = nullptr)
     : vars(vars_)
     , inputs(inputs_)
     , outputs(outputs_)
     , stateSince(since_)
+    , now(now_)
+    , script(script_)
     {}
 
+    // -- Symbol resolution ------------------------------------------------
+
+    /** @return Slot id of variable @p n, or kNoSymbol. */
+    SymbolId varId(const std::string& n) const noexcept { return vars.find(n); }
+
+    /** @return Slot id of input @p in, or kNoSymbol. */
+    SymbolId inputId(const std::string& in) const noexcept { return inputs.find(in); }
+
+    /** @return Slot id of output @p name (declared on first use). */
+    SymbolId outputId(const std::string& name) { return outputs.declare(name); }
+
+    // -- Id-based API -----------------------------------------------------
+
+    /**
+     * @brief  Set a variable slot to a new value.
+     * @tparam T   Type of the value (must match declared Variable::Type).
+     * @param id  Slot id of the variable.
+     * @param v   New value to assign.
+     */
+    template<class T>
+    void setVar(SymbolId id, const T& v) {
+        vars.set(id, Value{v});
+    }
+
+    /**
+     * @brief  Get the current value of a variable slot.
+     * @tparam T   Expected type of the variable’s value.
+     * @param id  Slot id of the variable.
+     * @return    The stored value cast to T.
+     */
+    template<class T>
+    T getVar(SymbolId id) const {
+        return std::get<T>(vars.value(id));
+    }
+
+    /** @return True if input slot @p id currently holds a value. */
+    bool defined(SymbolId id) const noexcept {
+        return inputs.has(id);
+    }
+
+    /** @return Last-seen value of input slot @p id, or empty string if undefined. */
+    const std::string& valueof(SymbolId id) const noexcept {
+        static const std::string empty;
+        return inputs.has(id) ? inputs.get(id) : empty;
+    }
+
+    /** @brief Emit a value on output slot @p id. */
+    void output(SymbolId id, const std::string& val) {
+        outputs.set(id, val);
+    }
+
+    // -- Name-based API (compatibility layer) -----------------------------
+
     /**
      * @brief  Set a variable to a new value.
      * @tparam T   Type of the value (must match declared Variable::Type).
      * @param n   Name of the variable.
      * @param v   New value to assign.
+     * @throws    std::runtime_error if the variable is not found.
      */
     template<class T>
     void setVar(const std::string& n, const T& v) {
-        vars[n].set(Value{v});
+        SymbolId id = vars.find(n);
+        if (id == kNoSymbol) {
+            throw std::runtime_error("var not found");
+        }
+        setVar(id, v);
     }
 
     /**
@@ -88,20 +158,20 @@ struct Context {
      */
     template<class T>
     T getVar(const std::string& n) const {
-        auto it = vars.find(n);
-        if (it == vars.end()) {
+        SymbolId id = vars.find(n);
+        if (id == kNoSymbol) {
             throw std::runtime_error("var not found");
         }
-        return std::get<T>(it->second.value());
+        return getVar<T>(id);
     }
 
     /**
      * @brief  Check whether an input with the given name is defined.
      * @param in  Input name.
-     * @return    True if present in inputs map; false otherwise.
+     * @return    True if present in inputs; false otherwise.
      */
     bool defined(const std::string& in) const noexcept {
-        return inputs.find(in) != inputs.end();
+        return inputs.has(inputs.find(in));
     }
 
     /**
@@ -110,8 +180,7 @@ struct Context {
      * @return    The input’s string value, or empty string if undefined.
      */
     std::string valueof(const std::string& in) const {
-        auto it = inputs.find(in);
-        return (it == inputs.end()) ? "" : it->second;
+        return valueof(inputs.find(in));
     }
 
     /**
@@ -120,16 +189,16 @@ struct Context {
      * @param val    Value to assign.
      */
     void output(const std::string& name, const std::string& val) {
-        outputs[name] = val;
+        outputs.set(name, val);
     }
 
     /**
      * @brief  Compute milliseconds elapsed since state entry.
-     * @return    Duration in milliseconds since stateSince.
+     * @return    Duration in milliseconds from stateSince to now.
      */
     std::chrono::milliseconds elapsed() const {
         return std::chrono::duration_cast<std::chrono::milliseconds>(
-            Clock::now() - stateSince);
+            now - stateSince);
     }
 };
 
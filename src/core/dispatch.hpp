@@ -0,0 +1,171 @@
+/**
+ * @file   dispatch.hpp
+ * @brief  Declares Dispatch, the dispatch, delay and arm rules shared by
+ *         Automaton and FsmInstance.
+ *
+ * Both run the same model semantics over different timer storage: the
+ * Scheduler of an Automaton, and the few timers of an FsmInstance's
+ * active state.  The rules are written once here against the small timer
+ * interface both provide.
+ *
+ * @author Martin Ševčík (xsevcim00)
+ * @author Jakub Lůčný (xlucnyj00)
+ * @date   2025-05-06
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <variant>
+#include "compiled_fsm.hpp"
+#include "log.hpp"
+#include "slots.hpp"
+#include "time_source.hpp"
+#include "transition.hpp"
+
+namespace core_fsm {
+
+/**
+ * @struct Dispatch
+ * @brief One dispatch of a trigger on one running copy of a model.
+ *
+ * Built on the stack by the owner for each dispatch; it only refers to the
+ * owner's state.  @p Timers is the timer storage, keyed by transition
+ * index, with the members Scheduler has:
+ *
+ * - `bool pending(std::size_t i) const` — a live timer exists
+ * - `std::optional<TimePoint> armedFrom(std::size_t i) const` — start of
+ *   the live countdown
+ * - `std::optional<TimePoint> firedAt(std::size_t i) const` — deadline it
+ *   last fired at since the state was entered
+ * - `void armFrom(std::size_t i, TimePoint from, Duration delay)` — arm
+ *   (or re-arm) to fire @p delay after @p from
+ */
+template <typename Timers>
+struct Dispatch {
+    using Duration  = std::chrono::milliseconds;
+    using TimePoint = std::chrono::steady_clock::time_point;
+
+    /// Returned by armEnabled() when no transition is to be taken now
+    static constexpr std::size_t kNoTransition = static_cast<std::size_t>(-1);
+
+    const CompiledFsm& model;          ///< Shared model
+    const std::size_t& active;         ///< Active state (moved by the fire callback)
+    const VarSlots&    vars;           ///< Live variables (delay variables)
+    GuardCtx           guards;         ///< View the guards evaluate against
+    Timers&            timers;         ///< Timers of the active state
+    const TimeSource&  time;           ///< Clock the countdowns start from
+    bool               runToCompletion;///< Fire undelayed transitions in-step
+    std::size_t        maxMicrosteps;  ///< Livelock guard per step
+    bool&              livelockReported; ///< Warned about the guard already
+
+    /**
+     * @brief Delay of transition @p i: its variable's value (ms), its
+     *        fixed delay, or zero.
+     */
+    Duration delayOf(std::size_t i) const noexcept {
+        const Transition& t = model.transitions()[i];
+        if (t.hasVariableDelay()) {
+            const SymbolId var = model.delayVar(i);
+            if (var != kNoSymbol) {
+                if (auto iv = std::get_if<int>(&vars.value(var)))
+                    return Duration(*iv);
+                if (auto dv = std::get_if<double>(&vars.value(var)))
+                    return Duration(static_cast<int>(*dv));
+            }
+            return Duration{0};
+        }
+        return t.isDelayed() ? t.delay() : Duration{0};
+    }
+
+    /**
+     * @brief Arm the transitions leaving the active state on @p trig whose
+     *        guards hold.
+     *
+     * Undelayed ones go through a 1 ms timer, unless @p sync is set: then
+     * the first of them is returned instead of being armed.
+     *
+     * @return Transition to fire now, or kNoTransition.
+     */
+    std::size_t armEnabled(SymbolId trig, bool sync) {
+        // Only transitions leaving the active state on this trigger can match
+        if (trig == kNoSymbol || active >= model.states().size()) return kNoTransition;
+        const auto* rowEnd = model.rowEnd(active);
+        const auto* first = std::lower_bound(model.rowBegin(active), rowEnd, trig,
+            [](const CompiledFsm::DispatchEntry& e, SymbolId id) { return e.trigger < id; });
+        if (first == rowEnd || first->trigger != trig) return kNoTransition;
+
+        for (auto e = first; e != rowEnd && e->trigger == trig; ++e) {
+            const std::size_t i = e->transition;
+            const Transition& t = model.transitions()[i];
+            if (!t.guardHolds(guards)) continue;
+
+            // Undelayed: take it now, or go through a 1 ms timer
+            Duration delay = delayOf(i);
+            if (delay.count() <= 0) {
+                if (sync) return i;
+                delay = Duration{1};
+            }
+
+            FSM_LOG(Timer, Debug, "arm " << t.src() << " → " << t.dst()
+                    << " delay=" << delay.count() << "ms");
+            if (t.inputName().empty()) {
+                // Unconditional: the countdown starts when the guard first
+                // holds in this state, or when this transition last fired if
+                // it loops back; arming again only moves the deadline if the
+                // delay changed
+                const TimePoint base = timers.pending(i)
+                    ? *timers.armedFrom(i)
+                    : timers.firedAt(i).value_or(time.now());
+                timers.armFrom(i, base, delay);
+            }
+            else if (!timers.pending(i)) {
+                // Triggered: the first matching input starts the countdown
+                timers.armFrom(i, time.now(), delay);
+            }
+        }
+        return kNoTransition;
+    }
+
+    /**
+     * @brief Dispatch @p trig, then the undelayed unconditional transitions
+     *        of the states it leads to.
+     *
+     * In run-to-completion mode an enabled transition without delay fires
+     * right here (a microstep), up to maxMicrosteps.  Past the bound the
+     * next step is armed as a 1 ms timer instead, so a livelocked model
+     * still yields to its driver; the first time, a warning is logged.
+     *
+     * @param fire  Called as fire(transition, trigger slot) to enter the
+     *              target state; it updates @c active.
+     * @return      True if a transition fired.
+     */
+    template <typename Fire>
+    bool run(SymbolId trig, Fire&& fire) {
+        bool fired = false;
+        std::size_t microsteps = 0;
+        while (trig != kNoSymbol) {
+            const bool sync = runToCompletion && microsteps < maxMicrosteps;
+            const std::size_t next = armEnabled(trig, sync);
+            if (next == kNoTransition) break;
+
+            fire(next, trig);
+            fired = true;
+            if (++microsteps == maxMicrosteps && !livelockReported) {
+                livelockReported = true;
+                FSM_LOG(Engine, Warn, maxMicrosteps
+                        << " microsteps without settling in '"
+                        << model.states()[active].name()
+                        << "', deferring to the scheduler");
+            }
+
+            // Continue with the unconditional transitions of the new state
+            trig = model.unconditional();
+        }
+        return fired;
+    }
+};
+
+} // namespace core_fsm
@@ -0,0 +1,170 @@
+/**
+ * @file   fsm_instance.cpp
+ * @brief  Implements FsmInstance: dispatch, timers and state entry of one
+ *         running copy of a CompiledFsm.
+ *
+ * @author Martin Ševčík (xsevcim00)
+ * @author Jakub Lůčný (xlucnyj00)
+ * @date   2025-05-06
+ */
+
+#include "fsm_instance.hpp"
+#include <algorithm>
+#include <iostream>
+#include "context.hpp"
+#include "dispatch.hpp"
+
+namespace core_fsm {
+
+using Duration = std::chrono::milliseconds;
+
+// Copy the slot templates; the name tables stay shared with the model
+FsmInstance::FsmInstance(std::shared_ptr<const CompiledFsm> model)
+: m_model(std::move(model))
+, m_vars(m_model->initialVars())
+, m_inputs(m_model->inputLayout())
+, m_outputs(m_model->outputLayout())
+, m_active(m_model->initialState())
+{}
+
+// Enter the initial state: start its clock, arm/fire its unconditional transitions
+bool FsmInstance::start() {
+    m_stateSince = m_time->now();
+    return dispatch(m_model->unconditional());
+}
+
+// Store the input value and dispatch on its slot
+bool FsmInstance::inject(const std::string& name, const std::string& value) {
+    return dispatch(m_inputs.set(name, value));
+}
+
+/**
+ * Parses @p valueStr according to the variable's declared type, falling
+ * back to the string itself, like Automaton::setVariable().
+ */
+bool FsmInstance::setVariable(const std::string& name, const std::string& valueStr) {
+    SymbolId id = m_vars.find(name);
+    if (id == kNoSymbol) return false;
+    try {
+        switch (m_vars.type(id)) {
+        case Variable::Type::Int:
+            m_vars.set(id, std::stoi(valueStr));
+            break;
+        case Variable::Type::Double:
+            m_vars.set(id, std::stod(valueStr));
+            break;
+        case Variable::Type::String:
+        default:
+            m_vars.set(id, valueStr);
+        }
+    }
+    catch (...) {
+        m_vars.set(id, valueStr);
+    }
+    return true;
+}
+
+// Fire every due timer in deadline order, then the undelayed transitions
+std::size_t FsmInstance::advance() {
+    const TimePoint now = m_time->now();
+
+    // Collect first: firing a transition may clear the timers
+    std::vector<std::pair<TimePoint, std::uint32_t>> due;
+    for (Timer& t : m_timers.list) {
+        if (!t.pending || t.at > now) continue;
+        t.pending = false;
+        t.fired   = true;
+        t.firedAt = t.at;
+        due.emplace_back(t.at, t.transition);
+    }
+    std::sort(due.begin(), due.end());
+    for (const auto& d : due)
+        fire(d.second);
+
+    dispatch(m_model->unconditional());
+    return due.size();
+}
+
+// Earliest pending deadline
+std::optional<FsmInstance::TimePoint> FsmInstance::nextDeadline() const noexcept {
+    std::optional<TimePoint> next;
+    for (const Timer& t : m_timers.list)
+        if (t.pending && (!next || t.at < *next)) next = t.at;
+    return next;
+}
+
+const std::string& FsmInstance::currentState() const noexcept {
+    return m_model->states()[m_active].name();
+}
+
+// Dispatch on @p trig with the model's run-to-completion settings
+bool FsmInstance::dispatch(SymbolId trig) {
+    const CompiledFsm& m = *m_model;
+    Dispatch<Timers> d{m, m_active, m_vars, GuardCtx{m_vars, m_inputs, nullptr},
+                       m_timers, *m_time,
+                       m.runToCompletion(), m.maxMicrosteps(), m_livelockReported};
+    return d.run(trig, [this](std::size_t next, SymbolId) { fire(next); });
+}
+
+/**
+ * Enters the target state of @p transition.  A different state starts a
+ * new clock and drops all timers; self-loops keep both.
+ */
+void FsmInstance::fire(std::size_t transition) {
+    const Transition& t = m_model->transitions()[transition];
+    if (t.src() != m_active) return;
+
+    const std::size_t old = m_active;
+    m_active = t.dst();
+    if (m_active != old) {
+        m_stateSince = m_time->now();
+        m_timers.list.clear();
+    }
+
+    Context ctx{m_vars, m_inputs, m_outputs, m_stateSince, m_time->now()};
+    m_model->states()[m_active].onEnter(ctx);
+    m_inputs.clear();
+}
+
+// Timer entry of @p transition in the active state, if any
+FsmInstance::Timer* FsmInstance::Timers::find(std::size_t transition) noexcept {
+    for (Timer& t : list)
+        if (t.transition == transition) return &t;
+    return nullptr;
+}
+
+const FsmInstance::Timer* FsmInstance::Timers::find(std::size_t transition) const noexcept {
+    return const_cast<Timers*>(this)->find(transition);
+}
+
+bool FsmInstance::Timers::pending(std::size_t transition) const noexcept {
+    const Timer* t = find(transition);
+    return t && t->pending;
+}
+
+std::optional<FsmInstance::TimePoint> FsmInstance::Timers::armedFrom(std::size_t transition) const noexcept {
+    const Timer* t = find(transition);
+    if (!t || !t->pending) return std::nullopt;
+    return t->from;
+}
+
+std::optional<FsmInstance::TimePoint> FsmInstance::Timers::firedAt(std::size_t transition) const noexcept {
+    const Timer* t = find(transition);
+    if (!t || !t->fired) return std::nullopt;
+    return t->firedAt;
+}
+
+// Arm (or move) the timer of @p transition to fire @p delay after @p from
+void FsmInstance::Timers::armFrom(std::size_t transition, TimePoint from,
+                                  std::chrono::milliseconds delay) {
+    Timer* t = find(transition);
+    if (!t) {
+        list.push_back(Timer{from + delay, from, {}, static_cast<std::uint32_t>(transition), true, false});
+        return;
+    }
+    t->at      = from + delay;
+    t->from    = from;
+    t->pending = true;
+}
+
+} // namespace core_fsm
@@ -0,0 +1,143 @@
+/**
+ * @file   fsm_instance.hpp
+ * @brief  Declares FsmInstance, the per-run state of a CompiledFsm: active
+ *         state, variable and I/O values and the pending timers.
+ *
+ * @author Martin Ševčík (xsevcim00)
+ * @author Jakub Lůčný (xlucnyj00)
+ * @date   2025-05-06
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+#include "compiled_fsm.hpp"
+#include "slots.hpp"
+#include "time_source.hpp"
+
+namespace core_fsm {
+
+/**
+ * @class FsmInstance
+ * @brief One running copy of a shared CompiledFsm.
+ *
+ * Follows the semantics of Automaton (dispatch, delays, run-to-completion
+ * per the model's setting; the rules are shared, see Dispatch) but holds
+ * nothing else: no input queue, channel, log or JS mirrors.  It is driven synchronously by its owner through
+ * inject(), advance() and nextDeadline(), from one thread at a time.
+ * Script guards and actions go through the calling thread's engine and
+ * scratch context.
+ *
+ * Instances of one model may run on different threads: the model was
+ * bound to its slot layout when it was frozen and is only read here.
+ */
+class FsmInstance {
+public:
+    using Clock     = std::chrono::steady_clock;
+    using TimePoint = Clock::time_point;
+
+    /**
+     * @brief Create an instance in the model's initial state.
+     * @param model  Shared compiled model.
+     */
+    explicit FsmInstance(std::shared_ptr<const CompiledFsm> model);
+
+    /**
+     * @brief Start the initial state's clock and arm its transitions.
+     * @return True if a transition fired.
+     */
+    bool start();
+
+    /**
+     * @brief Deliver an input and dispatch the transitions it enables.
+     * @param name   Input name.
+     * @param value  Input value.
+     * @return       True if a transition fired.
+     */
+    bool inject(const std::string& name, const std::string& value);
+
+    /**
+     * @brief Update a variable from its string form (see Automaton::setVariable()).
+     * @return True if @p name is a variable.
+     */
+    bool setVariable(const std::string& name, const std::string& valueStr);
+
+    /**
+     * @brief Fire the timers due by now, then undelayed transitions.
+     * @return Number of timers fired.
+     */
+    std::size_t advance();
+
+    /** @return Earliest pending timer, if any. */
+    std::optional<TimePoint> nextDeadline() const noexcept;
+
+    /**
+     * @brief Read time from @p time instead of steady_clock (before start()).
+     * @param time  Must outlive the instance; may be shared by many instances.
+     */
+    void setTimeSource(const TimeSource& time) noexcept { m_time = &time; }
+
+    /** @return Index of the active state. */
+    std::size_t activeState() const noexcept { return m_active; }
+
+    /** @return Name of the active state. */
+    const std::string& currentState() const noexcept;
+
+    /** @return Current variables. */
+    const VarSlots& vars() const noexcept { return m_vars; }
+
+    /** @return Last-seen inputs. */
+    const IOSlots& inputs() const noexcept { return m_inputs; }
+
+    /** @return Last-emitted outputs. */
+    const IOSlots& outputs() const noexcept { return m_outputs; }
+
+    /** @return The shared model. */
+    const CompiledFsm& model() const noexcept { return *m_model; }
+
+private:
+    /// Timer of one transition leaving the active state
+    struct Timer {
+        TimePoint     at;         // Deadline while pending
+        TimePoint     from;       // When the pending countdown started
+        TimePoint     firedAt;    // Deadline it last fired at (if fired)
+        std::uint32_t transition; // Index into the model's transitions
+        bool          pending;    // Armed and not fired yet
+        bool          fired;      // Fired since the state was entered
+    };
+
+    /// The few timers of the active state, with the Scheduler members
+    /// Dispatch arms them through
+    struct Timers {
+        std::vector<Timer> list;
+
+        bool pending(std::size_t transition) const noexcept;
+        std::optional<TimePoint> armedFrom(std::size_t transition) const noexcept;
+        std::optional<TimePoint> firedAt(std::size_t transition) const noexcept;
+        void armFrom(std::size_t transition, TimePoint from, std::chrono::milliseconds delay);
+
+        Timer*       find(std::size_t transition) noexcept;
+        const Timer* find(std::size_t transition) const noexcept;
+    };
+
+    bool        dispatch(SymbolId trig);
+    void        fire(std::size_t transition);
+
+    std::shared_ptr<const CompiledFsm> m_model;   // Shared, read-only
+    VarSlots                m_vars;               // Variable values
+    IOSlots                 m_inputs;             // Last-seen inputs
+    IOSlots                 m_outputs;            // Last-emitted outputs
+    Timers                  m_timers;             // Timers of the active state
+    TimePoint               m_stateSince{};       // When the active state was entered
+    const TimeSource*       m_time{&TimeSource::steady()}; // Clock of timers and state entry
+    std::size_t             m_active{0};          // Active state index
+    bool                    m_livelockReported{false}; // Warned about the microstep bound
+};
+
+} // namespace core_fsm
@@ -12,8 +12,11 @@
 #ifndef IO_BRIDGE_CHANNEL_HPP
 #define IO_BRIDGE_CHANNEL_HPP
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <memory>
+#include <vector>
 
 namespace io_bridge {
 
@@ -27,6 +30,14 @@ struct Packet {
     std::string json;
 };
 
+/// Most packets moved by one pollBatch()/sendBatch() system call
+constexpr std::size_t BATCH_SIZE = 32;
+
+/// Largest UDP payload over IPv4 (65535 minus the 8-byte UDP and 20-byte
+/// IP headers).  Every message, a "batch" included, is one datagram, so
+/// this is also the largest message a UDP transport carries.
+constexpr std::size_t MAX_DATAGRAM = 65507;
+
 /**
  * @class IChannel
  * @brief Abstract transport interface for sending and polling Packets.
@@ -56,6 +67,50 @@ public:
      * @return          True if a packet was received and pkt is populated.
      */
     virtual bool poll(Packet &pkt) noexcept = 0;
+
+    /**
+     * @brief Send several packets in order.
+     *
+     * The default calls send() for each; transports with a batched system
+     * call override it.
+     *
+     * @param pkts  First packet.
+     * @param n     Number of packets.
+     * @return      Packets sent; stops at the first failure.
+     */
+    virtual std::size_t sendBatch(const Packet *pkts, std::size_t n) noexcept {
+        std::size_t sent = 0;
+        while (sent < n && send(pkts[sent])) ++sent;
+        return sent;
+    }
+
+    /**
+     * @brief Non-blocking poll for up to @p max packets.
+     *
+     * The packets land in out[0 .. n); @p out grows as needed but never
+     * shrinks, so its strings keep their buffers between calls.
+     *
+     * @param[out] out  Receives the packets.
+     * @param      max  Upper bound (a transport may return fewer per call,
+     *                  see BATCH_SIZE).
+     * @return          Number of packets received.
+     */
+    virtual std::size_t pollBatch(std::vector<Packet> &out, std::size_t max) noexcept {
+        std::size_t n = 0;
+        for (; n < max; ++n) {
+            if (out.size() == n) out.emplace_back();
+            if (!poll(out[n])) break;
+        }
+        return n;
+    }
+
+    /**
+     * @brief Incoming packets discarded because they did not fit the
+     *        receive buffer (never passed on cut short).
+     *
+     * @return  Running total since the channel was opened.
+     */
+    virtual std::uint64_t dropped() const noexcept { return 0; }
 };
 
 /**
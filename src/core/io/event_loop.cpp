@@ -0,0 +1,133 @@
+/**
+ * @file   event_loop.cpp
+ * @brief  Implements EventLoop on top of epoll, eventfd and signalfd.
+ *
+ * @author Martin Ševčík (xsevcim00)
+ * @author Jakub Lůčný (xlucnyj00)
+ * @date   2025-05-06
+ */
+
+#include "event_loop.hpp"
+#include <cerrno>
+#include <csignal>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <unistd.h>
+
+namespace io_bridge {
+
+EventLoop::EventLoop() noexcept {
+    m_epoll  = ::epoll_create1(EPOLL_CLOEXEC);
+    m_wakeFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_epoll < 0 || m_wakeFd < 0) return;
+
+    epoll_event ev{};
+    ev.events  = EPOLLIN;
+    ev.data.fd = m_wakeFd;
+    ::epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_wakeFd, &ev);
+}
+
+EventLoop::~EventLoop() noexcept {
+    if (m_signalFd >= 0) ::close(m_signalFd);
+    if (m_wakeFd >= 0)   ::close(m_wakeFd);
+    if (m_epoll >= 0)    ::close(m_epoll);
+}
+
+// Register fd level-triggered, so a handler may leave data for the next round
+bool EventLoop::add(int fd, Handler h) {
+    if (m_epoll < 0) return false;
+    epoll_event ev{};
+    ev.events  = EPOLLIN;
+    ev.data.fd = fd;
+    if (::epoll_ctl(m_epoll, EPOLL_CTL_ADD, fd, &ev) < 0) return false;
+    m_handlers[fd] = std::make_shared<Handler>(std::move(h));
+    return true;
+}
+
+void EventLoop::remove(int fd) noexcept {
+    if (m_handlers.erase(fd) && m_epoll >= 0)
+        ::epoll_ctl(m_epoll, EPOLL_CTL_DEL, fd, nullptr);
+}
+
+// One signalfd carries every watched signal; its mask grows with each call
+bool EventLoop::watchSignal(int signo, SignalHandler h) {
+    if (m_epoll < 0) return false;
+    sigset_t mask;
+    sigemptyset(&mask);
+    for (const auto& s : m_signals) sigaddset(&mask, s.first);
+    sigaddset(&mask, signo);
+    if (::pthread_sigmask(SIG_BLOCK, &mask, nullptr) != 0) return false;
+
+    const bool fresh = m_signalFd < 0;
+    const int  fd    = ::signalfd(m_signalFd, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (fd < 0) return false;
+    m_signalFd = fd;
+    if (fresh) {
+        epoll_event ev{};
+        ev.events  = EPOLLIN;
+        ev.data.fd = m_signalFd;
+        ::epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_signalFd, &ev);
+    }
+    m_signals[signo] = std::move(h);
+    return true;
+}
+
+// Read every pending signal and dispatch it
+void EventLoop::onSignal() {
+    signalfd_siginfo info;
+    while (::read(m_signalFd, &info, sizeof(info)) == sizeof(info)) {
+        auto it = m_signals.find(static_cast<int>(info.ssi_signo));
+        if (it != m_signals.end() && it->second) it->second(static_cast<int>(info.ssi_signo));
+    }
+}
+
+std::size_t EventLoop::runOnce(std::chrono::milliseconds timeout) {
+    if (m_epoll < 0) return 0;
+    constexpr int kMaxEvents = 16;
+    epoll_event events[kMaxEvents];
+
+    const int wait = timeout.count() < 0 ? -1 : static_cast<int>(timeout.count());
+    const int n = ::epoll_wait(m_epoll, events, kMaxEvents, wait);
+    if (n <= 0) return 0;   // timeout or EINTR
+
+    std::size_t handled = 0;
+    for (int i = 0; i < n; ++i) {
+        const int fd = events[i].data.fd;
+        if (fd == m_wakeFd) {
+            std::uint64_t count;
+            while (::read(m_wakeFd, &count, sizeof(count)) > 0) {}
+            continue;
+        }
+        if (fd == m_signalFd) {
+            onSignal();
+            ++handled;
+            continue;
+        }
+        auto it = m_handlers.find(fd);
+        if (it == m_handlers.end()) continue;   // removed by an earlier handler
+        auto h = it->second;                    // keep alive across remove()
+        (*h)(events[i].events);
+        ++handled;
+    }
+    return handled;
+}
+
+void EventLoop::run() {
+    while (!stopped())
+        runOnce(std::chrono::milliseconds(-1));
+}
+
+void EventLoop::wake() noexcept {
+    if (m_wakeFd < 0) return;
+    const std::uint64_t one = 1;
+    // EAGAIN only if the counter is saturated, i.e. a wakeup is pending anyway
+    [[maybe_unused]] auto r = ::write(m_wakeFd, &one, sizeof(one));
+}
+
+void EventLoop::stop() noexcept {
+    m_stop.store(true, std::memory_order_release);
+    wake();
+}
+
+} // namespace io_bridge
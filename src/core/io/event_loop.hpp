@@ -0,0 +1,113 @@
+/**
+ * @file   event_loop.hpp
+ * @brief  Declares EventLoop: an epoll reactor that dispatches readiness of
+ *         file descriptors, signals and wakeups to callbacks.
+ *
+ * The loop sleeps in epoll_wait() until a watched descriptor becomes ready,
+ * a watched signal arrives (signalfd), another thread calls wake()/stop()
+ * (eventfd) or the caller's timeout passes, so an idle process does not
+ * wake up at all.
+ *
+ * @author Martin Ševčík (xsevcim00)
+ * @author Jakub Lůčný (xlucnyj00)
+ * @date   2025-05-06
+ */
+
+#ifndef IO_BRIDGE_EVENT_LOOP_HPP
+#define IO_BRIDGE_EVENT_LOOP_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+
+namespace io_bridge {
+
+/**
+ * @class EventLoop
+ * @brief Single-threaded epoll reactor.
+ *
+ * Callbacks run on the thread calling runOnce()/run().  Only wake() and
+ * stop() may be called from other threads (or from a signal handler).
+ */
+class EventLoop {
+public:
+    /// Readiness callback; receives the epoll event mask.
+    using Handler = std::function<void(std::uint32_t events)>;
+
+    /// Signal callback; receives the signal number.
+    using SignalHandler = std::function<void(int signo)>;
+
+    /**
+     * @brief Creates the epoll instance and the wakeup eventfd.
+     * @note noexcept: on failure the loop is invalid (see valid()).
+     */
+    EventLoop() noexcept;
+
+    /** @brief Closes the epoll, eventfd and signalfd descriptors. */
+    ~EventLoop() noexcept;
+
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    /** @return True if epoll and the wakeup eventfd were created. */
+    bool valid() const noexcept { return m_epoll >= 0 && m_wakeFd >= 0; }
+
+    /**
+     * @brief Watch @p fd for readability (level-triggered).
+     * @param fd  Descriptor; not owned by the loop.
+     * @param h   Called with the ready events.
+     * @return    False if epoll refuses the descriptor (e.g. a regular file).
+     */
+    bool add(int fd, Handler h);
+
+    /** @brief Stop watching @p fd (safe from within its own handler). */
+    void remove(int fd) noexcept;
+
+    /**
+     * @brief Deliver @p signo through the loop instead of asynchronously.
+     *
+     * Blocks the signal in the calling thread; call it before starting
+     * other threads so they inherit the mask.
+     *
+     * @return False if the signalfd could not be set up.
+     */
+    bool watchSignal(int signo, SignalHandler h);
+
+    /**
+     * @brief Wait for readiness and run the handlers of the ready descriptors.
+     * @param timeout  Longest wait; negative waits until an event arrives.
+     * @return         Number of handlers run (0 on timeout or wakeup).
+     */
+    std::size_t runOnce(std::chrono::milliseconds timeout);
+
+    /** @brief Call runOnce() until stop(). */
+    void run();
+
+    /** @brief Interrupt a blocked runOnce() (any thread, async-signal-safe). */
+    void wake() noexcept;
+
+    /** @brief Make run() return; also wakes the loop (any thread). */
+    void stop() noexcept;
+
+    /** @return True once stop() was called. */
+    bool stopped() const noexcept { return m_stop.load(std::memory_order_acquire); }
+
+private:
+    void onSignal();
+
+    int                m_epoll{-1};      /**< epoll instance */
+    int                m_wakeFd{-1};     /**< eventfd for wake()/stop() */
+    int                m_signalFd{-1};   /**< signalfd of the watched signals */
+    std::atomic<bool>  m_stop{false};    /**< Set by stop() */
+
+    /// Handlers by descriptor; shared so remove() inside a handler is safe
+    std::unordered_map<int, std::shared_ptr<Handler>>  m_handlers;
+    std::unordered_map<int, SignalHandler>             m_signals;
+};
+
+} // namespace io_bridge
+
+#endif // IO_BRIDGE_EVENT_LOOP_HPP
@@ -52,6 +52,10 @@ void RuntimeClient::start() {
     m_channel = std::make_shared<UdpChannel>(
                     m_bindAddr.toStdString(),
                     m_peerAddr.toStdString());
+    m_dropped = 0;
+
+    // Offer the snapshot encodings (before the poller can answer)
+    sendHello();
 
     // 2) Move this object into a new QThread
     m_thread = new QThread(this);
@@ -61,6 +65,16 @@ void RuntimeClient::start() {
     m_thread->start();
 }
 
+// Sends the capability handshake; the reply is handled in pollChannel()
+void RuntimeClient::sendHello() {
+    if (!m_channel) return;
+    nlohmann::json formats = nlohmann::json::array();
+    for (const QString& f : m_offer)
+        formats.push_back(f.toStdString());
+    sendCustomMessage(nlohmann::json{{"type", "hello"}, {"formats", formats}}.dump());
+    m_helloSent = std::chrono::steady_clock::now();
+}
+
 // Sends any arbitrary JSON message over UDP
 void RuntimeClient::sendCustomMessage(const std::string& jsonMessage) {
     io_bridge::Packet pkt;
@@ -97,38 +111,91 @@ void RuntimeClient::onThreadStarted() {
 }
 
 
-// Polls the UDP channel; on valid “state” JSON, emits snapshot + log
+// Polls the UDP channel, draining everything queued since the last tick
+// (BATCH_SIZE datagrams per system call)
 void RuntimeClient::pollChannel()
 {
-    Packet p;
-    if (!m_channel || !m_channel->poll(p))
+    if (!m_channel)
         return;
+    std::size_t n;
+    do {
+        n = m_channel->pollBatch(m_inbox, io_bridge::BATCH_SIZE);
+        for (std::size_t i = 0; i < n; ++i)
+            handlePacket(m_inbox[i]);
+    } while (n == io_bridge::BATCH_SIZE);
+
+    // Truncated snapshots never reach handlePacket(); say so, since the
+    // next delta will ask for a keyframe
+    if (const auto dropped = m_channel->dropped(); dropped != m_dropped) {
+        emit logMessage(QString("DROPPED: %1 truncated datagram(s)").arg(dropped - m_dropped));
+        m_dropped = dropped;
+    }
+}
 
+// On a valid “state” (keyframe) or “delta” JSON, rebuilds the full
+// snapshot and emits it + log
+void RuntimeClient::handlePacket(const Packet& p)
+{
     // ---------- parse packet ------------------------------------------------
-    auto j = nlohmann::json::parse(p.json, nullptr, false);
-    if (j.is_discarded() || j.value("type","") != "state")
+    // Text JSON, or the binary encoding agreed in the handshake
+    auto j = io_bridge::decode(p.json, m_format);
+    if (j.is_discarded()) return;
+    const std::string type = j.value("type", "");
+    if (type == "hello") {
+        m_format     = io_bridge::parseFormat(j.value("format", "json"))
+                           .value_or(io_bridge::WireFormat::Json);
+        m_helloAcked = true;
+        emit logMessage(QString("WIRE FORMAT: %1").arg(io_bridge::formatName(m_format)));
         return;
+    }
+    const bool delta = (type == "delta");
+    if (!delta && type != "state")
+        return;
+
+    // Our hello got lost (e.g. the runtime was not up yet): offer again
+    if (!m_helloAcked && std::chrono::steady_clock::now() - m_helloSent > std::chrono::seconds(1))
+        sendHello();
+
+    // A delta only applies on top of the message it names ("prev"; seq
+    // itself skips the events the runtime coalesced); after a lost
+    // datagram (or when joining late) wait for a keyframe
+    const quint64 seq  = j.value("seq", quint64{0});
+    const quint64 prev = j.value("prev", seq - 1);
+    if (delta && (!m_hasPrev || prev != m_lastSeq)) {
+        if (!m_keyframeAsked) {
+            sendCustomMessage(nlohmann::json{{"type", "keyframe"}}.dump());
+            m_keyframeAsked = true;
+        }
+        return;
+    }
+    m_lastSeq = seq;
+    if (!delta) m_keyframeAsked = false;
 
     StateSnapshot snap;
+    snap.seq   = seq;
+    snap.ts    = j.value("ts", qint64{0});
     snap.state = QString::fromStdString(j.at("state").get<std::string>());
 
-    // helper: JSON object → QMap<QString,QString>
-    auto jsonToMap = [&](auto const& node) {
-    QMap<QString,QString> map;
+    // helper: JSON object applied onto @p map → QMap<QString,QString>
+    // (null removes an entry, as deltas send for unset inputs)
+    auto jsonToMap = [&](QMap<QString,QString> map, auto const& node) {
     for (auto it = node.begin(); it != node.end(); ++it) {
+        const QString key = QString::fromStdString(it.key());
         QString val;
-        if      (it.value().is_string())        val = QString::fromStdString(it.value().template get<std::string>());
+        if      (it.value().is_null())          { map.remove(key); continue; }
+        else if (it.value().is_string())        val = QString::fromStdString(it.value().template get<std::string>());
         else if (it.value().is_number_integer()) val = QString::number(it.value().template get<qint64>());
         else if (it.value().is_number_float())   val = QString::number(it.value().template get<double>());
         else                                     val = QString::fromStdString(it.value().dump());
-        map.insert(QString::fromStdString(it.key()), val);
+        map.insert(key, val);
     }
     return map;
     };
 
-    snap.inputs  = jsonToMap(j.at("inputs"));
-    snap.vars    = jsonToMap(j.at("vars"));
-    snap.outputs = jsonToMap(j.at("outputs"));
+    using Map = QMap<QString,QString>;
+    snap.inputs  = jsonToMap(delta ? m_prevInputs  : Map{}, j.at("inputs"));
+    snap.vars    = jsonToMap(delta ? m_prevVars    : Map{}, j.at("vars"));
+    snap.outputs = jsonToMap(delta ? m_prevOutputs : Map{}, j.at("outputs"));
 
     // ---------- NEW: diff against previous snapshot -------------------------
     auto reportChanges = [this](const char* tag,
@@ -5,7 +5,10 @@
  *
  * RuntimeClient wraps an io_bridge::UdpChannel to send control messages
  * (inject, setVar, shutdown) and to poll for “state” JSON packets, which
- * it emits as StateSnapshot signals on the Qt event loop.
+ * it emits as StateSnapshot signals on the Qt event loop.  “delta”
+ * packets are applied on top of the previous snapshot, so every emitted
+ * snapshot is complete.  A `hello` handshake lets the runtime send the
+ * snapshots in a binary encoding (see wire_format.hpp).
  *
  * @author Martin Ševčík (xsevcim00)
  * @author Jakub Lůčný (xlucnyj00)
@@ -20,10 +23,14 @@
 #include <QTimer>
 #include <QString>
 #include <QMap>
+#include <QStringList>
 #include <QProcess>
 #include <memory>
+#include <vector>
 #include "channel.hpp"
 #include "udp_channel.hpp"
+#include "wire_format.hpp"
+#include <chrono>
 #include <nlohmann/json.hpp>
 
 /**
@@ -69,6 +76,15 @@ public:
      */
     ~RuntimeClient() override;
 
+    /**
+     * @brief Sets the snapshot encodings offered in the handshake, most
+     *        preferred first (default: json only).
+     *
+     * Binary encodings are opt-in, e.g. `{"msgpack", "cbor", "json"}`;
+     * keep "json" last so older runtimes still match.  Call before start().
+     */
+    void setWireFormats(QStringList formats) { m_offer = std::move(formats); }
+
     /**
      * @brief Starts the polling thread and begins receiving state updates.
      *
@@ -122,14 +138,37 @@ private slots:
     /**
      * @brief Polls the UDP socket for incoming packets and
      *        emits stateReceived/logMessage as appropriate.
+     *
+     * Every packet queued since the last tick is handled, received in
+     * batches (see IChannel::pollBatch()).
      */
     void pollChannel();
 
 private:
+    /**
+     * @brief Handles one packet: the `hello` reply or a snapshot.
+     *
+     * Deltas are merged into the previous snapshot; when a delta does not
+     * follow the last message applied, a keyframe is requested and deltas
+     * are skipped until it arrives.
+     */
+    void handlePacket(const io_bridge::Packet& p);
+
+    /** @brief Sends the `hello` listing the offered encodings. */
+    void sendHello();
+
     QMap<QString,QString> m_prevInputs;
     QMap<QString,QString> m_prevOutputs;
     QMap<QString,QString> m_prevVars;
     bool                  m_hasPrev = false;
+    quint64               m_lastSeq = 0;          /**< Seq of the last message applied */
+    bool                  m_keyframeAsked = false; /**< Keyframe requested, not yet received */
+    QStringList           m_offer{"json"};   /**< Encodings offered in `hello` */
+    io_bridge::WireFormat m_format = io_bridge::WireFormat::Json; /**< Encoding the runtime agreed to */
+    bool                  m_helloAcked = false;   /**< Runtime answered the `hello` */
+    std::chrono::steady_clock::time_point m_helloSent; /**< When the last `hello` went out */
+    std::vector<io_bridge::Packet> m_inbox;       /**< Receive batch (buffers reused) */
+    std::uint64_t         m_dropped = 0;          /**< Truncated datagrams already reported */
     const QString                              m_bindAddr;
     const QString                              m_peerAddr;
     std::shared_ptr<io_bridge::IChannel>       m_channel;  /**< Underlying UDP channel */
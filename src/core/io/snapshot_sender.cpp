@@ -0,0 +1,56 @@
+/**
+ * @file   snapshot_sender.cpp
+ * @brief  Implements the snapshot sender thread.
+ *
+ * @author Martin Ševčík (xsevcim00)
+ * @author Jakub Lůčný (xlucnyj00)
+ * @date   2025-05-06
+ */
+
+#include "snapshot_sender.hpp"
+#include "wire_format.hpp"
+#include "../log.hpp"
+
+using namespace io_bridge;
+
+SnapshotSender::SnapshotSender(ChannelPtr channel, std::size_t capacity, Overflow overflow)
+    : m_channel(std::move(channel))
+    , m_overflow(overflow)
+    , m_ring(capacity)
+    , m_thread([this] { run(); })
+{}
+
+SnapshotSender::~SnapshotSender() {
+    m_stop.store(true, std::memory_order_release);
+    m_wakeup.unpark();
+    m_thread.join();
+}
+
+std::optional<SnapshotSender::Overflow>
+SnapshotSender::parseOverflow(const std::string& name) noexcept {
+    if (name == "drop")     return Overflow::DropNewest;
+    if (name == "coalesce") return Overflow::Coalesce;
+    return std::nullopt;
+}
+
+void SnapshotSender::run() {
+    Packet out[BATCH_SIZE];   // Encoded snapshots (buffers reused)
+    for (;;) {
+        const bool stopping = m_stop.load(std::memory_order_acquire);
+
+        // Encode a batch, then send it with one system call
+        std::size_t count = 0;
+        const auto n = m_ring.drain([&](core_fsm::SnapshotRecord& r) {
+            const auto j = core_fsm::toJson(r);
+            encode(j, r.format, out[count++].json);
+            FSM_LOG(Snapshot, Debug, "RUNTIME → UDP: " << j.dump());
+        }, BATCH_SIZE);
+        if (n > 0) m_channel->sendBatch(out, n);
+        m_sent.fetch_add(n, std::memory_order_relaxed);
+
+        if (n == 0) {
+            if (stopping) break;
+            m_wakeup.park(std::chrono::hours(1));
+        }
+    }
+}
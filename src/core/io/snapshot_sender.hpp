@@ -0,0 +1,108 @@
+/**
+ * @file   snapshot_sender.hpp
+ * @brief  Declares SnapshotSender: an I/O thread that encodes and sends the
+ *         snapshots an automaton publishes.
+ *
+ * The automaton copies each snapshot into a slot of a single-producer /
+ * single-consumer ring and returns; building the JSON document, encoding
+ * it and the send (batched, see IChannel::sendBatch()) all happen on the
+ * sender's thread, so a slow or full socket never stalls the engine.
+ *
+ * @author Martin Ševčík (xsevcim00)
+ * @author Jakub Lůčný (xlucnyj00)
+ * @date   2025-05-06
+ */
+
+#ifndef IO_BRIDGE_SNAPSHOT_SENDER_HPP
+#define IO_BRIDGE_SNAPSHOT_SENDER_HPP
+
+#include "channel.hpp"
+#include "../parker.hpp"
+#include "../snapshot_record.hpp"
+#include "../spsc_ring.hpp"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+
+namespace io_bridge {
+
+/**
+ * @class SnapshotSender
+ * @brief Owns the snapshot ring and the thread draining it into a channel.
+ *
+ * One automaton publishes (the producer side of the ring is not shared);
+ * the channel's send() is then only called from the sender thread, next
+ * to whatever control traffic the owner sends itself.
+ */
+class SnapshotSender {
+public:
+    /// What happens to a snapshot published while the ring is full
+    enum class Overflow : std::uint8_t {
+        DropNewest,  ///< Discard it; the next event's snapshot carries its changes
+        Coalesce     ///< Discard it but retry shortly, so the latest state is always sent
+    };
+
+    /**
+     * @brief Starts the sender thread.
+     * @param channel   Where snapshots go.
+     * @param capacity  Ring slots (rounded up to a power of two).
+     * @param overflow  Policy when the ring is full.
+     */
+    explicit SnapshotSender(ChannelPtr channel,
+                            std::size_t capacity = 64,
+                            Overflow overflow = Overflow::Coalesce);
+
+    /** @brief Sends what is still queued, then stops the thread. */
+    ~SnapshotSender();
+
+    SnapshotSender(const SnapshotSender&) = delete;
+    SnapshotSender& operator=(const SnapshotSender&) = delete;
+
+    /**
+     * @brief Queue a snapshot (publishing thread only; never blocks).
+     * @param fill  Callable receiving the slot's core_fsm::SnapshotRecord&;
+     *              the record still holds a previous snapshot's data.
+     * @return      False if the ring was full and @p fill was not called.
+     */
+    template<typename Fill>
+    bool tryPublish(Fill&& fill) {
+        if (!m_ring.tryPush(std::forward<Fill>(fill))) {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        m_wakeup.unpark();
+        return true;
+    }
+
+    /** @return Policy when the ring is full. */
+    Overflow overflow() const noexcept { return m_overflow; }
+
+    /** @return Snapshots handed to the channel so far. */
+    std::uint64_t sent() const noexcept { return m_sent.load(std::memory_order_relaxed); }
+
+    /** @return Snapshots refused because the ring was full. */
+    std::uint64_t dropped() const noexcept { return m_dropped.load(std::memory_order_relaxed); }
+
+    /** @return The overflow policy called @p name ("drop", "coalesce"), if known. */
+    static std::optional<Overflow> parseOverflow(const std::string& name) noexcept;
+
+private:
+    /// Sender thread: drain the ring, encode, send in batches; park when empty
+    void run();
+
+    ChannelPtr                                   m_channel;
+    Overflow                                     m_overflow;
+    core_fsm::SpscRing<core_fsm::SnapshotRecord> m_ring;     // Snapshots waiting to be sent
+    core_fsm::Parker                             m_wakeup;   // Sleeping sender thread
+    std::atomic<std::uint64_t>                   m_sent{0};
+    std::atomic<std::uint64_t>                   m_dropped{0};
+    std::atomic<bool>                            m_stop{false};
+    std::thread                                  m_thread;   // Last: starts once the rest exists
+};
+
+} // namespace io_bridge
+
+#endif // IO_BRIDGE_SNAPSHOT_SENDER_HPP
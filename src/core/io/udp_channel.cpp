@@ -1,6 +1,7 @@
 /**
  * @file   udp_channel.cpp
- * @brief  Implements UdpChannel: socket setup, send(), and poll().
+ * @brief  Implements UdpChannel: socket setup, send(), poll() and their
+ *         batched forms.
  *
  * Includes a helper to parse "IP:port" strings into sockaddr_in.
  *
@@ -10,6 +11,7 @@
  */
 
 #include "udp_channel.hpp"
+#include <algorithm>
 #include <cstring>
 
 namespace io_bridge {
@@ -79,16 +81,82 @@ bool UdpChannel::poll(Packet &pkt) noexcept {
     sockaddr_in src{};
     socklen_t   slen = sizeof(src);
 
-    // Attempt to receive; non-blocking
-    int n = ::recvfrom(m_sock,
-                    m_buf, BUF_SIZE, 0,
-                    reinterpret_cast<sockaddr*>(&src), &slen);
+    // Attempt to receive; non-blocking.  MSG_TRUNC makes recvfrom()
+    // return the full datagram length, so a cut-off one shows
+    int n;
+    while ((n = ::recvfrom(m_sock,
+                        m_buf.get(), BUF_SIZE, MSG_TRUNC,
+                        reinterpret_cast<sockaddr*>(&src), &slen))
+           > static_cast<int>(BUF_SIZE))
+        ++m_dropped;
     if (n <= 0)
         return false;  // no data or error
 
     // Populate Packet JSON string
-    pkt.json.assign(m_buf, static_cast<size_t>(n));
+    pkt.json.assign(m_buf.get(), static_cast<size_t>(n));
     return true;
 }
 
+std::size_t UdpChannel::sendBatch(const Packet *pkts, std::size_t n) noexcept {
+    if (m_sock < 0) return 0;
+    mmsghdr msgs[BATCH_SIZE];
+    iovec   iov[BATCH_SIZE];
+
+    std::size_t done = 0;
+    while (done < n) {
+        const auto count = std::min(n - done, BATCH_SIZE);
+        for (std::size_t i = 0; i < count; ++i) {
+            const auto &json = pkts[done + i].json;
+            iov[i]  = { const_cast<char*>(json.data()), json.size() };
+            msgs[i] = {};
+            msgs[i].msg_hdr.msg_name    = &m_peer;
+            msgs[i].msg_hdr.msg_namelen = sizeof(m_peer);
+            msgs[i].msg_hdr.msg_iov     = &iov[i];
+            msgs[i].msg_hdr.msg_iovlen  = 1;
+        }
+        // All datagrams to the peer in one system call
+        const int sent = ::sendmmsg(m_sock, msgs, static_cast<unsigned>(count), 0);
+        if (sent <= 0) break;
+        done += static_cast<std::size_t>(sent);
+        if (static_cast<std::size_t>(sent) < count) break;   // Socket buffer full
+    }
+    return done;
+}
+
+std::size_t UdpChannel::pollBatch(std::vector<Packet> &out, std::size_t max) noexcept {
+    if (m_sock < 0) return 0;
+    const auto count = std::min(max, BATCH_SIZE);
+    if (out.size() < count) out.resize(count);
+    mmsghdr msgs[BATCH_SIZE];
+    iovec   iov[BATCH_SIZE];
+
+    std::size_t got = 0;
+    while (got < count) {
+        const auto want = count - got;
+        for (std::size_t i = 0; i < want; ++i) {
+            iov[i]  = { &m_batchBuf[i * BUF_SIZE], BUF_SIZE };
+            msgs[i] = {};
+            msgs[i].msg_hdr.msg_iov    = &iov[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        // Whatever is queued, up to want datagrams; non-blocking
+        const int n = ::recvmmsg(m_sock, msgs, static_cast<unsigned>(want), MSG_DONTWAIT, nullptr);
+        if (n <= 0)
+            break;  // no data or error
+
+        for (int i = 0; i < n; ++i) {
+            // A datagram cut to the buffer would parse as garbage (or worse,
+            // as a shorter valid message): drop it
+            if (msgs[i].msg_hdr.msg_flags & MSG_TRUNC) {
+                ++m_dropped;
+                continue;
+            }
+            out[got++].json.assign(&m_batchBuf[i * BUF_SIZE], msgs[i].msg_len);
+        }
+        if (static_cast<std::size_t>(n) < want) break;   // Socket drained
+    }
+    return got;
+}
+
 } // namespace io_bridge
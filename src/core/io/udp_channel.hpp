@@ -3,7 +3,10 @@
  * @brief  Declares UdpChannel: a non-blocking UDP IChannel transport.
  *
  * UdpChannel binds a UDP socket to a local endpoint and sends/receives
- * JSON-based Packet structs to/from a specified peer address.
+ * JSON-based Packet structs to/from a specified peer address.  The batch
+ * calls move up to BATCH_SIZE datagrams per recvmmsg()/sendmmsg().  The
+ * receive buffers hold a full MAX_DATAGRAM each; a datagram the kernel
+ * still reports as truncated is dropped and counted (see dropped()).
  *
  * @author Martin Ševčík (xsevcim00)
  * @author Jakub Lůčný (xlucnyj00)
@@ -14,6 +17,7 @@
 #define IO_BRIDGE_UDP_CHANNEL_HPP
 
 #include "channel.hpp"
+#include <memory>
 #include <string>
 #include <unistd.h>
 #include <sys/socket.h>
@@ -54,16 +58,49 @@ public:
 
     /**
      * @brief Non-blocking receive of a UDP datagram.
+     *
+     * Truncated datagrams are skipped and counted.
+     *
      * @param[out] pkt  Filled with the JSON string on success.
      * @return     True if data was received; false if no data or error.
      */
     bool poll(Packet &pkt) noexcept override;
 
+    /**
+     * @brief Sends packets as datagrams, BATCH_SIZE per sendmmsg() call.
+     * @return Packets sent; fewer than @p n if the socket refused one.
+     */
+    std::size_t sendBatch(const Packet *pkts, std::size_t n) noexcept override;
+
+    /**
+     * @brief Receives up to min(@p max, BATCH_SIZE) datagrams with
+     *        non-blocking recvmmsg() calls.
+     *
+     * Truncated datagrams are skipped and counted, and their slots are
+     * refilled, so a short batch still means the socket is drained.
+     *
+     * @return Number of packets received into out[0 .. n).
+     */
+    std::size_t pollBatch(std::vector<Packet> &out, std::size_t max) noexcept override;
+
+    /** @brief Datagrams dropped as truncated since the socket was opened. */
+    std::uint64_t dropped() const noexcept override { return m_dropped; }
+
+    /**
+     * @brief The socket, for readiness notification (e.g. EventLoop::add()).
+     * @return Socket FD, or -1 if the channel failed to open.
+     */
+    int fd() const noexcept { return m_sock; }
+
 private:
     int           m_sock{-1};               /**< UDP socket FD or -1 on error */
     sockaddr_in   m_peer{};                 /**< Cached peer address */
-    static constexpr size_t BUF_SIZE = 2048;/**< Receive buffer capacity */
-    char          m_buf[BUF_SIZE];          /**< Temporary recv buffer */
+    std::uint64_t m_dropped{0};             /**< Truncated datagrams skipped */
+    static constexpr size_t BUF_SIZE = MAX_DATAGRAM; /**< Receive buffer capacity */
+    /// Temporary recv buffer (heap: pages are only touched as datagrams arrive)
+    std::unique_ptr<char[]> m_buf{new char[BUF_SIZE]};
+    /// Receive buffers of pollBatch(), BUF_SIZE bytes each
+    std::unique_ptr<char[]> m_batchBuf{new char[BATCH_SIZE * BUF_SIZE]};
 };
 
 } // namespace io_bridge
@@ -0,0 +1,82 @@
+/**
+ * @file   wire_format.hpp
+ * @brief  Encodings of snapshot packets: text JSON or a binary form of the
+ *         same document (MessagePack, CBOR).
+ *
+ * The runtime speaks JSON until a client asks for something else with a
+ * `hello` message listing the formats it understands; control messages
+ * stay JSON in both directions.  A text packet always starts with '{', so
+ * a receiver can tell JSON from the binary forms by the first byte.
+ *
+ * @author Martin Ševčík (xsevcim00)
+ * @author Jakub Lůčný (xlucnyj00)
+ * @date   2025-05-06
+ */
+
+#ifndef IO_BRIDGE_WIRE_FORMAT_HPP
+#define IO_BRIDGE_WIRE_FORMAT_HPP
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <nlohmann/json.hpp>
+
+namespace io_bridge {
+
+/// Encoding of snapshot packets.
+enum class WireFormat : std::uint8_t {
+    Json,     ///< Text, for debugging and old clients (the default)
+    MsgPack,  ///< MessagePack
+    Cbor      ///< CBOR (RFC 8949)
+};
+
+/** @return Name of @p f used in the handshake ("json", "msgpack", "cbor"). */
+inline const char* formatName(WireFormat f) noexcept {
+    switch (f) {
+    case WireFormat::MsgPack: return "msgpack";
+    case WireFormat::Cbor:    return "cbor";
+    default:                  return "json";
+    }
+}
+
+/** @return The format called @p name, if known. */
+inline std::optional<WireFormat> parseFormat(const std::string& name) noexcept {
+    if (name == "json")    return WireFormat::Json;
+    if (name == "msgpack") return WireFormat::MsgPack;
+    if (name == "cbor")    return WireFormat::Cbor;
+    return std::nullopt;
+}
+
+/**
+ * @brief Encode @p j in format @p f into @p out (its buffer is reused).
+ */
+inline void encode(const nlohmann::json& j, WireFormat f, std::string& out) {
+    out.clear();
+    switch (f) {
+    case WireFormat::MsgPack:
+        nlohmann::json::to_msgpack(j, nlohmann::detail::output_adapter<char>(out));
+        break;
+    case WireFormat::Cbor:
+        nlohmann::json::to_cbor(j, nlohmann::detail::output_adapter<char>(out));
+        break;
+    default:
+        out = j.dump();
+        break;
+    }
+}
+
+/**
+ * @brief Decode a packet encoded as JSON or as @p f.
+ * @return The document, or a discarded value if it is malformed.
+ */
+inline nlohmann::json decode(const std::string& bytes, WireFormat f) {
+    if (bytes.empty() || bytes.front() == '{' || f == WireFormat::Json)
+        return nlohmann::json::parse(bytes, nullptr, false);
+    if (f == WireFormat::MsgPack)
+        return nlohmann::json::from_msgpack(bytes, true, false);
+    return nlohmann::json::from_cbor(bytes, true, false);
+}
+
+} // namespace io_bridge
+
+#endif // IO_BRIDGE_WIRE_FORMAT_HPP
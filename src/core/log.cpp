@@ -0,0 +1,161 @@
+/**
+ * @file   log.cpp
+ * @brief  Implements the log queue, its background writer and the
+ *         threshold configuration.
+ *
+ * @author Martin Ševčík (xsevcim00)
+ * @author Jakub Lůčný (xlucnyj00)
+ * @date   2025-05-06
+ */
+
+#include "log.hpp"
+#include "mpsc_queue.hpp"
+#include "parker.hpp"
+#include <cstdio>
+#include <sstream>
+#include <thread>
+
+namespace core_fsm::log {
+
+namespace {
+
+constexpr const char* kCategoryNames[] = { "engine", "timer", "snapshot", "runtime" };
+constexpr const char* kLevelNames[]    = { "trace", "debug", "info", "warn", "error", "off" };
+
+/// One queued message; slots keep their text buffers between uses
+struct Entry {
+    Category    cat{Category::Engine};
+    Level       level{Level::Info};
+    std::string text;
+};
+
+/**
+ * Queue plus writer thread, created on the first message.  Producers only
+ * wake the writer when it sleeps (Parker), so a burst costs one wakeup.
+ */
+class Sink {
+public:
+    Sink() : m_writer([this] { writeLoop(); }) {}
+
+    ~Sink() {
+        m_stop.store(true, std::memory_order_release);
+        m_wakeup.unpark();
+        m_writer.join();
+    }
+
+    void push(Category c, Level l, const std::string& text) {
+        const bool queued = m_ring.tryPush([&](Entry& e) {
+            e.cat   = c;
+            e.level = l;
+            e.text.assign(text);
+        });
+        if (!queued) {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        m_queued.fetch_add(1, std::memory_order_release);
+        m_wakeup.unpark();
+    }
+
+    void flush() {
+        const auto target = m_queued.load(std::memory_order_acquire);
+        while (m_written.load(std::memory_order_acquire) < target) {
+            m_wakeup.unpark();
+            std::this_thread::yield();
+        }
+    }
+
+    std::uint64_t dropped() const noexcept { return m_dropped.load(std::memory_order_relaxed); }
+
+private:
+    void writeLoop() {
+        std::string out;
+        std::uint64_t reported = 0;
+        for (;;) {
+            const bool stopping = m_stop.load(std::memory_order_acquire);
+
+            // Format the whole backlog into one write
+            out.clear();
+            const auto n = m_ring.drain([&](Entry& e) {
+                out += '[';
+                out += kCategoryNames[static_cast<int>(e.cat)];
+                if (e.level >= Level::Warn) {
+                    out += ' ';
+                    out += kLevelNames[static_cast<int>(e.level)];
+                }
+                out += "] ";
+                out += e.text;
+                out += '\n';
+            });
+            const auto lost = dropped();
+            if (lost != reported) {
+                out += "[log] " + std::to_string(lost - reported) + " messages dropped\n";
+                reported = lost;
+            }
+            if (!out.empty()) {
+                std::fwrite(out.data(), 1, out.size(), stderr);
+                std::fflush(stderr);
+            }
+            m_written.fetch_add(n, std::memory_order_release);
+
+            if (n == 0) {
+                if (stopping) break;
+                m_wakeup.park(std::chrono::hours(1));
+            }
+        }
+    }
+
+    MpscRing<Entry>            m_ring{4096};   // Messages waiting for the writer
+    Parker                     m_wakeup;       // Sleeping writer
+    std::atomic<std::uint64_t> m_queued{0};
+    std::atomic<std::uint64_t> m_written{0};
+    std::atomic<std::uint64_t> m_dropped{0};
+    std::atomic<bool>          m_stop{false};
+    std::thread                m_writer;       // Last: starts once the rest exists
+};
+
+Sink& sink() {
+    static Sink instance;
+    return instance;
+}
+
+template<std::size_t N>
+int indexOf(const char* const (&names)[N], const std::string& name) {
+    for (std::size_t i = 0; i < N; ++i)
+        if (name == names[i]) return static_cast<int>(i);
+    return -1;
+}
+
+} // namespace
+
+void setLevel(Category c, Level l) noexcept {
+    g_threshold[static_cast<std::size_t>(c)].store(static_cast<std::uint8_t>(l),
+                                                   std::memory_order_relaxed);
+}
+
+bool configure(const std::string& spec) {
+    std::istringstream in(spec);
+    std::string item;
+    while (std::getline(in, item, ',')) {
+        const auto eq = item.find('=');
+        const int level = indexOf(kLevelNames, eq == std::string::npos ? item : item.substr(eq + 1));
+        if (level < 0) return false;
+        if (eq == std::string::npos) {
+            for (std::size_t c = 0; c < static_cast<std::size_t>(Category::Count); ++c)
+                setLevel(static_cast<Category>(c), static_cast<Level>(level));
+            continue;
+        }
+        const int cat = indexOf(kCategoryNames, item.substr(0, eq));
+        if (cat < 0) return false;
+        setLevel(static_cast<Category>(cat), static_cast<Level>(level));
+    }
+    return true;
+}
+
+void submit(Category c, Level l, const std::string& text) { sink().push(c, l, text); }
+
+void flush() { sink().flush(); }
+
+std::uint64_t dropped() noexcept { return sink().dropped(); }
+
+} // namespace core_fsm::log
@@ -0,0 +1,135 @@
+/**
+ * @file   log.hpp
+ * @brief  Leveled, per-category logging that stays off the engine thread.
+ *
+ * A message is formatted by the calling thread and queued in a lock-free
+ * ring; a background writer prints it to stderr.  Categories below the
+ * compile-time minimum (FSM_LOG_MIN_LEVEL, FSM_LOG_CATEGORIES) vanish
+ * from the binary, and a category switched off at run time costs one
+ * relaxed load: the message is not even formatted.
+ *
+ *     FSM_LOG(Timer, Debug, "arm " << src << " -> " << dst);
+ *
+ * @author Martin Ševčík (xsevcim00)
+ * @author Jakub Lůčný (xlucnyj00)
+ * @date   2025-05-06
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+/// Lowest level compiled in (0 = Trace ... 4 = Error, 5 = nothing).
+#ifndef FSM_LOG_MIN_LEVEL
+#define FSM_LOG_MIN_LEVEL 0
+#endif
+
+/// Bit mask of the categories compiled in (bit n = Category n).
+#ifndef FSM_LOG_CATEGORIES
+#define FSM_LOG_CATEGORIES 0xff
+#endif
+
+namespace core_fsm::log {
+
+/// Message severity.
+enum class Level : std::uint8_t { Trace, Debug, Info, Warn, Error, Off };
+
+/// What a message is about; each has its own threshold.
+enum class Category : std::uint8_t {
+    Engine,    ///< Automaton execution (microsteps, livelock)
+    Timer,     ///< Arming and firing of delayed transitions
+    Snapshot,  ///< State snapshots sent to clients
+    Runtime,   ///< fsm_runtime process
+    Count
+};
+
+/// FSM_LOG_MIN_LEVEL as a typed constant
+constexpr int kMinLevel = FSM_LOG_MIN_LEVEL;
+
+/** @return True if messages of @p c at @p l are compiled in. */
+constexpr bool compiledIn(Category c, Level l) noexcept {
+    return static_cast<int>(l) >= kMinLevel &&
+           ((FSM_LOG_CATEGORIES >> static_cast<int>(c)) & 1) != 0;
+}
+
+/// Run-time threshold per category (Info by default)
+inline std::atomic<std::uint8_t> g_threshold[static_cast<std::size_t>(Category::Count)] = {
+    static_cast<std::uint8_t>(Level::Info), static_cast<std::uint8_t>(Level::Info),
+    static_cast<std::uint8_t>(Level::Info), static_cast<std::uint8_t>(Level::Info)
+};
+
+/** @return True if messages of @p c at @p l are printed right now. */
+inline bool enabled(Category c, Level l) noexcept {
+    return static_cast<std::uint8_t>(l) >=
+           g_threshold[static_cast<std::size_t>(c)].load(std::memory_order_relaxed);
+}
+
+/** @brief Print messages of @p c from level @p l up (any thread). */
+void setLevel(Category c, Level l) noexcept;
+
+/**
+ * @brief Set thresholds from a spec such as `debug` (every category) or
+ *        `snapshot=debug,timer=trace`.
+ * @return False if the spec names an unknown category or level.
+ */
+bool configure(const std::string& spec);
+
+/** @brief Block until every message queued so far has been written. */
+void flush();
+
+/** @return Messages dropped because the queue was full. */
+std::uint64_t dropped() noexcept;
+
+/** @brief Queue a formatted message; drops it if the queue is full. */
+void submit(Category c, Level l, const std::string& text);
+
+/**
+ * @class Line
+ * @brief Collects one message (in a per-thread buffer) and queues it when
+ *        destroyed.  Used through FSM_LOG.
+ */
+class Line {
+public:
+    Line(Category c, Level l) : m_cat(c), m_level(l) { buffer().clear(); }
+    ~Line() { submit(m_cat, m_level, buffer()); }
+
+    Line(const Line&) = delete;
+    Line& operator=(const Line&) = delete;
+
+    Line& operator<<(const std::string& s) { buffer() += s; return *this; }
+    Line& operator<<(const char* s)        { buffer() += s; return *this; }
+    Line& operator<<(char c)               { buffer() += c; return *this; }
+
+    template<typename T, typename = std::enable_if_t<std::is_arithmetic_v<T>>>
+    Line& operator<<(T v) { buffer() += std::to_string(v); return *this; }
+
+private:
+    static std::string& buffer() {
+        thread_local std::string text;
+        return text;
+    }
+
+    Category m_cat;
+    Level    m_level;
+};
+
+} // namespace core_fsm::log
+
+/**
+ * Log `a << b << ...` under category @p cat at level @p lvl (enumerator
+ * names, e.g. FSM_LOG(Snapshot, Debug, ...)).  The operands are only
+ * evaluated when the message is enabled.
+ */
+#define FSM_LOG(cat, lvl, msg)                                                        \
+    do {                                                                              \
+        if constexpr (::core_fsm::log::compiledIn(::core_fsm::log::Category::cat,     \
+                                                  ::core_fsm::log::Level::lvl))       \
+            if (::core_fsm::log::enabled(::core_fsm::log::Category::cat,              \
+                                         ::core_fsm::log::Level::lvl))                \
+                ::core_fsm::log::Line(::core_fsm::log::Category::cat,                 \
+                                      ::core_fsm::log::Level::lvl) << msg;            \
+    } while (0)
@@ -0,0 +1,165 @@
+/**
+ * @file   mpsc_queue.hpp
+ * @brief  Bounded lock-free multi-producer/single-consumer ring buffer.
+ *
+ * Used for the reactor's ready list, the log queue and, when built with
+ * FSM_LOCKFREE_INPUT_QUEUE, the automaton's input queue: any number of
+ * threads push, one consumer drains in batches without taking a lock.
+ *
+ * @author Martin Ševčík (xsevcim00)
+ * @author Jakub Lůčný (xlucnyj00)
+ * @date   2025-05-06
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace core_fsm {
+
+/**
+ * @class MpscRing
+ * @brief Bounded MPSC queue with preallocated slots (Vyukov-style).
+ *
+ * Every slot carries a sequence number telling whether it is free for the
+ * producer claiming position @c pos (seq == pos) or holds an element ready
+ * for the consumer (seq == pos + 1).  Producers claim positions with a CAS
+ * on the tail; the single consumer needs no atomic read-modify-write at
+ * all.  Elements are written and read in place, so slots keep their
+ * buffers (e.g. std::string capacity) from one use to the next.
+ *
+ * @tparam T  Slot payload; must be default constructible.
+ */
+template<typename T>
+class MpscRing {
+public:
+    /**
+     * @brief Create a ring.
+     * @param capacity  Number of slots, rounded up to a power of two.
+     */
+    explicit MpscRing(std::size_t capacity) {
+        std::size_t size = 2;
+        while (size < capacity) size <<= 1;
+        m_mask  = size - 1;
+        m_cells = std::make_unique<Cell[]>(size);
+        for (std::size_t i = 0; i < size; ++i)
+            m_cells[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    MpscRing(const MpscRing&) = delete;
+    MpscRing& operator=(const MpscRing&) = delete;
+
+    /**
+     * @brief Enqueue one element (any thread).
+     * @param write  Callable receiving the slot's T& to fill in.
+     * @return       False if the ring is full.
+     */
+    template<typename Fn>
+    bool tryPush(Fn&& write) {
+        std::size_t pos = m_tail.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &m_cells[pos & m_mask];
+            const std::size_t seq = cell->seq.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos);
+            if (diff == 0) {
+                if (m_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0) {
+                return false;   // consumer has not released this slot yet
+            }
+            else {
+                pos = m_tail.load(std::memory_order_relaxed);
+            }
+        }
+        write(cell->value);
+        cell->seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Enqueue @p n elements in consecutive slots (any thread).
+     *
+     * The run is claimed with a single CAS, so elements of other producers
+     * never interleave with it.  The consumer frees slots in order, hence
+     * the last slot of the run being free means the whole run is.
+     *
+     * @param n      Number of elements; at most capacity().
+     * @param write  Callable receiving (index, T&) for each slot to fill in.
+     * @return       False if the ring has fewer than @p n free slots.
+     */
+    template<typename Fn>
+    bool tryPushN(std::size_t n, Fn&& write) {
+        if (n == 0) return true;
+        if (n > capacity()) return false;
+        std::size_t pos = m_tail.load(std::memory_order_relaxed);
+        for (;;) {
+            const std::size_t lastPos = pos + n - 1;
+            const std::size_t seq = m_cells[lastPos & m_mask].seq.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(lastPos);
+            if (diff == 0) {
+                if (m_tail.compare_exchange_weak(pos, pos + n, std::memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0) {
+                return false;
+            }
+            else {
+                pos = m_tail.load(std::memory_order_relaxed);
+            }
+        }
+        for (std::size_t i = 0; i < n; ++i) {
+            Cell& cell = m_cells[(pos + i) & m_mask];
+            write(i, cell.value);
+            cell.seq.store(pos + i + 1, std::memory_order_release);
+        }
+        return true;
+    }
+
+    /**
+     * @brief Consume ready elements in FIFO order (consumer thread only).
+     * @param read  Callable receiving each slot's T& before it is released.
+     * @param max   Upper bound on elements consumed by this call.
+     * @return      Number of elements consumed.
+     */
+    template<typename Fn>
+    std::size_t drain(Fn&& read, std::size_t max = static_cast<std::size_t>(-1)) {
+        std::size_t n = 0;
+        while (n < max) {
+            Cell& cell = m_cells[m_head & m_mask];
+            if (cell.seq.load(std::memory_order_acquire) != m_head + 1) break;
+            read(cell.value);
+            cell.seq.store(m_head + m_mask + 1, std::memory_order_release);
+            ++m_head;
+            ++n;
+        }
+        return n;
+    }
+
+    /** @return True if no element is ready (consumer thread only). */
+    bool empty() const noexcept {
+        const Cell& cell = m_cells[m_head & m_mask];
+        return cell.seq.load(std::memory_order_acquire) != m_head + 1;
+    }
+
+    /** @return Number of slots. */
+    std::size_t capacity() const noexcept { return m_mask + 1; }
+
+private:
+    /// One slot, on its own cache line to keep producers apart.
+    struct alignas(64) Cell {
+        std::atomic<std::size_t> seq{0};
+        T                        value{};
+    };
+
+    std::unique_ptr<Cell[]>              m_cells;   ///< Preallocated slots
+    std::size_t                          m_mask{0}; ///< capacity - 1
+    alignas(64) std::atomic<std::size_t> m_tail{0}; ///< Next position to claim (producers)
+    alignas(64) std::size_t              m_head{0}; ///< Next position to read (consumer)
+};
+
+} // namespace core_fsm
@@ -0,0 +1,132 @@
+/**
+ * @file   mutex_queue.hpp
+ * @brief  Bounded mutex-guarded multi-producer/single-consumer queue.
+ *
+ * The automaton's default input queue.  Same interface as MpscRing, so the
+ * two can be swapped at build time (FSM_LOCKFREE_INPUT_QUEUE).
+ *
+ * @author Martin Ševčík (xsevcim00)
+ * @author Jakub Lůčný (xlucnyj00)
+ * @date   2025-05-06
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace core_fsm {
+
+/**
+ * @class MutexQueue
+ * @brief Bounded MPSC queue of two preallocated buffers behind one mutex.
+ *
+ * Producers fill the back buffer under the lock.  The consumer swaps it
+ * with the front buffer under the lock once the front one is used up, and
+ * reads the front one without holding it, so producers wait at most for
+ * a swap, never for the consumer's work.  Slots are reused in place, so
+ * they keep their buffers (e.g. std::string capacity) from one use to the
+ * next.
+ *
+ * @tparam T  Slot payload; must be default constructible.
+ */
+template<typename T>
+class MutexQueue {
+public:
+    /**
+     * @brief Create a queue.
+     * @param capacity  Number of elements the producers may have queued.
+     */
+    explicit MutexQueue(std::size_t capacity)
+        : m_back(capacity ? capacity : 1), m_front(m_back.size()) {}
+
+    MutexQueue(const MutexQueue&) = delete;
+    MutexQueue& operator=(const MutexQueue&) = delete;
+
+    /**
+     * @brief Enqueue one element (any thread).
+     * @param write  Callable receiving the slot's T& to fill in.
+     * @return       False if the queue is full.
+     */
+    template<typename Fn>
+    bool tryPush(Fn&& write) {
+        std::lock_guard<std::mutex> lk(m_mtx);
+        if (m_backSize == m_back.size()) return false;
+        write(m_back[m_backSize]);
+        m_queued.store(++m_backSize, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Enqueue @p n elements in consecutive slots (any thread).
+     *
+     * The whole run is written under one lock, so elements of other
+     * producers never interleave with it.
+     *
+     * @param n      Number of elements; at most capacity().
+     * @param write  Callable receiving (index, T&) for each slot to fill in.
+     * @return       False if the queue has fewer than @p n free slots.
+     */
+    template<typename Fn>
+    bool tryPushN(std::size_t n, Fn&& write) {
+        if (n == 0) return true;
+        std::lock_guard<std::mutex> lk(m_mtx);
+        if (n > m_back.size() - m_backSize) return false;
+        for (std::size_t i = 0; i < n; ++i)
+            write(i, m_back[m_backSize + i]);
+        m_backSize += n;
+        m_queued.store(m_backSize, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Consume queued elements in FIFO order (consumer thread only).
+     * @param read  Callable receiving each slot's T&.
+     * @param max   Upper bound on elements consumed by this call.
+     * @return      Number of elements consumed.
+     */
+    template<typename Fn>
+    std::size_t drain(Fn&& read, std::size_t max = static_cast<std::size_t>(-1)) {
+        std::size_t n = 0;
+        while (n < max) {
+            if (m_frontPos == m_frontSize && !swapBuffers()) break;
+            read(m_front[m_frontPos++]);
+            ++n;
+        }
+        return n;
+    }
+
+    /** @return True if no element is queued (consumer thread only). */
+    bool empty() const noexcept {
+        return m_frontPos == m_frontSize && m_queued.load(std::memory_order_acquire) == 0;
+    }
+
+    /** @return Number of slots producers may fill. */
+    std::size_t capacity() const noexcept { return m_back.size(); }
+
+private:
+    /// Take the producers' buffer; false if it is empty.
+    bool swapBuffers() {
+        if (m_queued.load(std::memory_order_acquire) == 0) return false;
+        std::lock_guard<std::mutex> lk(m_mtx);
+        std::swap(m_back, m_front);
+        m_frontSize = m_backSize;
+        m_frontPos  = 0;
+        m_backSize  = 0;
+        m_queued.store(0, std::memory_order_relaxed);
+        return true;
+    }
+
+    std::mutex               m_mtx;            ///< Guards m_back and m_backSize
+    std::vector<T>           m_back;           ///< Filled by producers
+    std::size_t              m_backSize{0};    ///< Elements in m_back
+    std::atomic<std::size_t> m_queued{0};      ///< m_backSize, readable without the lock
+    std::vector<T>           m_front;          ///< Being read by the consumer
+    std::size_t              m_frontSize{0};   ///< Elements in m_front
+    std::size_t              m_frontPos{0};    ///< Next element of m_front to read
+};
+
+} // namespace core_fsm
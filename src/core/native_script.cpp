@@ -0,0 +1,948 @@
+/**
+ * @file   native_script.cpp
+ * @brief  Implements the native guard/action compiler: a tokenizer and
+ *         recursive descent parser for the supported JS subset, and a typed
+ *         AST evaluator that mirrors JavaScript conversion semantics.
+ *
+ * @author Martin Ševčík (xsevcim00)
+ * @author Jakub Lůčný (xlucnyj00)
+ * @date   2025-05-06
+ */
+
+#include "native_script.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <climits>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+
+namespace core_fsm::native {
+
+namespace {
+
+constexpr double kNaN = std::numeric_limits<double>::quiet_NaN();
+
+/// JS whitespace (ASCII subset).
+bool isJsSpace(char c) noexcept {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+}
+
+std::string_view trim(std::string_view s) noexcept {
+    while (!s.empty() && isJsSpace(s.front())) s.remove_prefix(1);
+    while (!s.empty() && isJsSpace(s.back()))  s.remove_suffix(1);
+    return s;
+}
+
+/// JS `Number(s)` for strings: decimal, hex and Infinity literals.
+double stringToNumber(std::string_view s) {
+    s = trim(s);
+    if (s.empty()) return 0.0;
+    if (s == "Infinity" || s == "+Infinity") return  std::numeric_limits<double>::infinity();
+    if (s == "-Infinity")                    return -std::numeric_limits<double>::infinity();
+
+    if (s.size() > 2 && s[0] == '0' && (s[1] == 'x' || s[1] == 'X')) {
+        double d = 0.0;
+        for (char c : s.substr(2)) {
+            if (!std::isxdigit(static_cast<unsigned char>(c))) return kNaN;
+            d = d * 16 + (std::isdigit(static_cast<unsigned char>(c))
+                              ? c - '0'
+                              : std::tolower(static_cast<unsigned char>(c)) - 'a' + 10);
+        }
+        return d;
+    }
+
+    // [+-]? (digits [. digits?] | . digits) ([eE] [+-]? digits)?
+    std::size_t i = 0;
+    if (s[i] == '+' || s[i] == '-') ++i;
+    std::size_t mantissa = 0;
+    while (i < s.size() && std::isdigit(static_cast<unsigned char>(s[i]))) { ++i; ++mantissa; }
+    if (i < s.size() && s[i] == '.') {
+        ++i;
+        while (i < s.size() && std::isdigit(static_cast<unsigned char>(s[i]))) { ++i; ++mantissa; }
+    }
+    if (mantissa == 0) return kNaN;
+    if (i < s.size() && (s[i] == 'e' || s[i] == 'E')) {
+        ++i;
+        if (i < s.size() && (s[i] == '+' || s[i] == '-')) ++i;
+        std::size_t exp = 0;
+        while (i < s.size() && std::isdigit(static_cast<unsigned char>(s[i]))) { ++i; ++exp; }
+        if (exp == 0) return kNaN;
+    }
+    if (i != s.size()) return kNaN;
+    return std::strtod(std::string(s).c_str(), nullptr);
+}
+
+/// Thrown by the compiler when the source leaves the supported subset.
+struct Unsupported : std::runtime_error {
+    using std::runtime_error::runtime_error;
+};
+
+// -- Tokenizer ------------------------------------------------------------
+
+struct Token {
+    enum class Kind { End, Number, String, Ident, Punct };
+    Kind        kind{Kind::End};
+    std::string text;     ///< Identifier / punctuator / decoded string
+    double      number{0};
+    bool        newlineBefore{false}; ///< A line break precedes the token (for ASI)
+};
+
+class Lexer {
+public:
+    explicit Lexer(std::string_view src) : m_src(src) {}
+
+    Token next() {
+        bool newline = false;
+        while (m_pos < m_src.size() && isJsSpace(m_src[m_pos]))
+            newline |= m_src[m_pos++] == '\n';
+        Token t = scan();
+        t.newlineBefore = newline;
+        return t;
+    }
+
+private:
+    Token scan() {
+        Token t;
+        if (m_pos >= m_src.size()) return t;
+
+        char c = m_src[m_pos];
+        if (std::isdigit(static_cast<unsigned char>(c)) ||
+            (c == '.' && m_pos + 1 < m_src.size() &&
+             std::isdigit(static_cast<unsigned char>(m_src[m_pos + 1])))) {
+            return number();
+        }
+        if (c == '"' || c == '\'') return string(c);
+        if (std::isalpha(static_cast<unsigned char>(c)) || c == '_' || c == '$') {
+            std::size_t start = m_pos;
+            while (m_pos < m_src.size() &&
+                   (std::isalnum(static_cast<unsigned char>(m_src[m_pos])) ||
+                    m_src[m_pos] == '_' || m_src[m_pos] == '$')) {
+                ++m_pos;
+            }
+            t.kind = Token::Kind::Ident;
+            t.text = std::string(m_src.substr(start, m_pos - start));
+            return t;
+        }
+
+        static const char* const puncts[] = {
+            "===", "!==", "==", "!=", "<=", ">=", "&&", "||",
+            "++", "--", "+=", "-=",
+            "<", ">", "+", "-", "*", "/", "%", "!", "(", ")", ",", ";",
+            "=", "{", "}"
+        };
+        for (const char* p : puncts) {
+            std::string_view pv(p);
+            if (m_src.substr(m_pos, pv.size()) == pv) {
+                // Comments and compound operators are not part of the subset
+                if (pv == "/" && m_pos + 1 < m_src.size() &&
+                    (m_src[m_pos + 1] == '/' || m_src[m_pos + 1] == '*'))
+                    throw Unsupported("comments");
+                m_pos += pv.size();
+                t.kind = Token::Kind::Punct;
+                t.text = std::string(pv);
+                return t;
+            }
+        }
+        throw Unsupported(std::string("character '") + c + "'");
+    }
+
+    Token number() {
+        std::size_t start = m_pos;
+        if (m_src[m_pos] == '0' && m_pos + 1 < m_src.size() &&
+            (m_src[m_pos + 1] == 'x' || m_src[m_pos + 1] == 'X')) {
+            m_pos += 2;
+            while (m_pos < m_src.size() && std::isxdigit(static_cast<unsigned char>(m_src[m_pos]))) ++m_pos;
+        } else {
+            if (m_src[m_pos] == '0' && m_pos + 1 < m_src.size() &&
+                std::isdigit(static_cast<unsigned char>(m_src[m_pos + 1])))
+                throw Unsupported("legacy octal literal");
+            while (m_pos < m_src.size() && std::isdigit(static_cast<unsigned char>(m_src[m_pos]))) ++m_pos;
+            if (m_pos < m_src.size() && m_src[m_pos] == '.') {
+                ++m_pos;
+                while (m_pos < m_src.size() && std::isdigit(static_cast<unsigned char>(m_src[m_pos]))) ++m_pos;
+            }
+            if (m_pos < m_src.size() && (m_src[m_pos] == 'e' || m_src[m_pos] == 'E')) {
+                ++m_pos;
+                if (m_pos < m_src.size() && (m_src[m_pos] == '+' || m_src[m_pos] == '-')) ++m_pos;
+                while (m_pos < m_src.size() && std::isdigit(static_cast<unsigned char>(m_src[m_pos]))) ++m_pos;
+            }
+        }
+        if (m_pos < m_src.size() &&
+            (std::isalnum(static_cast<unsigned char>(m_src[m_pos])) || m_src[m_pos] == '_'))
+            throw Unsupported("malformed number");
+
+        Token t;
+        t.kind   = Token::Kind::Number;
+        t.number = stringToNumber(m_src.substr(start, m_pos - start));
+        if (std::isnan(t.number)) throw Unsupported("malformed number");
+        return t;
+    }
+
+    Token string(char quote) {
+        Token t;
+        t.kind = Token::Kind::String;
+        ++m_pos;
+        while (true) {
+            if (m_pos >= m_src.size()) throw Unsupported("unterminated string");
+            char c = m_src[m_pos++];
+            if (c == quote) break;
+            if (c == '\n') throw Unsupported("unterminated string");
+            if (c == '\\') {
+                if (m_pos >= m_src.size()) throw Unsupported("unterminated string");
+                char e = m_src[m_pos++];
+                switch (e) {
+                case 'n':  t.text += '\n'; break;
+                case 't':  t.text += '\t'; break;
+                case 'r':  t.text += '\r'; break;
+                case '\\': case '"': case '\'': t.text += e; break;
+                default:   throw Unsupported("string escape");
+                }
+                continue;
+            }
+            t.text += c;
+        }
+        return t;
+    }
+
+    std::string_view m_src;
+    std::size_t      m_pos{0};
+};
+
+} // namespace
+
+// -- Compiler -------------------------------------------------------------
+
+/**
+ * Recursive descent parser emitting nodes straight into a Program.
+ * Precedence (low → high): ||, &&, equality, relational, additive,
+ * multiplicative, unary, primary.  With @c vars set it accepts the action
+ * dialect (statements, variables, output, elapsed).
+ */
+struct Program::Compiler {
+    Program&           prog;
+    const VarSlots*    vars;      ///< Non-null when compiling an action
+    std::vector<Token> toks;
+    std::size_t        pos{0};
+    Token              tok;
+
+    Compiler(Program& p, std::string_view src, const VarSlots* actionVars = nullptr)
+        : prog(p), vars(actionVars)
+    {
+        Lexer lex(src);
+        do toks.push_back(lex.next());
+        while (toks.back().kind != Token::Kind::End);
+        tok = toks[0];
+    }
+
+    void advance() { if (pos + 1 < toks.size()) tok = toks[++pos]; }
+
+    const Token& peek() const { return toks[std::min(pos + 1, toks.size() - 1)]; }
+
+    bool isIdent(const char* id) const {
+        return tok.kind == Token::Kind::Ident && tok.text == id;
+    }
+
+    bool isPunct(const char* p) const {
+        return tok.kind == Token::Kind::Punct && tok.text == p;
+    }
+
+    void expect(const char* p) {
+        if (!isPunct(p)) throw Unsupported(std::string("expected '") + p + "'");
+        advance();
+    }
+
+    std::uint32_t emit(Op op, Type type, std::uint32_t a = 0, std::uint32_t b = 0) {
+        prog.m_nodes.push_back(Node{op, type, a, b});
+        return static_cast<std::uint32_t>(prog.m_nodes.size() - 1);
+    }
+
+    std::uint32_t constant(JsValue v) {
+        Type t = v.kind == JsValue::Kind::Number ? Type::Number
+               : v.kind == JsValue::Kind::String ? Type::String
+               : v.kind == JsValue::Kind::Bool   ? Type::Bool
+               : Type::Any;
+        prog.m_consts.push_back(std::move(v));
+        return emit(Op::Const, t, static_cast<std::uint32_t>(prog.m_consts.size() - 1));
+    }
+
+    std::uint32_t ref(const std::string& name) {
+        for (std::size_t i = 0; i < prog.m_refs.size(); ++i)
+            if (prog.m_refs[i].name == name) return static_cast<std::uint32_t>(i);
+        Ref r;
+        r.name = name;
+        if (vars) r.var = vars->find(name);
+        prog.m_refs.push_back(std::move(r));
+        return static_cast<std::uint32_t>(prog.m_refs.size() - 1);
+    }
+
+    /// Reference to a variable by bare identifier (actions only).
+    std::uint32_t varRef(const std::string& name) {
+        if (!vars) throw Unsupported("identifier '" + name + "'");
+        std::uint32_t r = ref(name);
+        if (prog.m_refs[r].var == kNoSymbol)
+            throw Unsupported("unknown identifier '" + name + "'");
+        return r;
+    }
+
+    std::uint32_t stmt(StmtOp op, std::uint32_t a, std::uint32_t b = 0,
+                       std::uint32_t c = kNoStmt) {
+        prog.m_stmts.push_back(Stmt{op, a, b, c});
+        return static_cast<std::uint32_t>(prog.m_stmts.size() - 1);
+    }
+
+    // -- Statements (actions) ---------------------------------------------
+
+    /// statements := statement* up to @p closer ("}" or end of input)
+    std::uint32_t block(bool braced) {
+        std::vector<std::uint32_t> items;
+        while (true) {
+            if (braced && isPunct("}")) { advance(); break; }
+            if (tok.kind == Token::Kind::End) {
+                if (braced) throw Unsupported("expected '}'");
+                break;
+            }
+            if (isPunct(";")) { advance(); continue; }
+            items.push_back(statement());
+        }
+        std::uint32_t first = static_cast<std::uint32_t>(prog.m_blockItems.size());
+        prog.m_blockItems.insert(prog.m_blockItems.end(), items.begin(), items.end());
+        return stmt(StmtOp::Block, first, static_cast<std::uint32_t>(items.size()));
+    }
+
+    std::uint32_t statement() {
+        if (isPunct("{")) { advance(); return block(true); }
+
+        if (isIdent("if")) {
+            advance();
+            expect("(");
+            std::uint32_t cond = expression();
+            expect(")");
+            std::uint32_t then = statement();
+            std::uint32_t otherwise = kNoStmt;
+            if (isIdent("else")) { advance(); otherwise = statement(); }
+            return stmt(StmtOp::If, cond, then, otherwise);
+        }
+
+        std::uint32_t s;
+        const bool assignOp = tok.kind == Token::Kind::Ident &&
+                              peek().kind == Token::Kind::Punct &&
+                              (peek().text == "=" || peek().text == "+=" || peek().text == "-=" ||
+                               peek().text == "++" || peek().text == "--");
+        if (assignOp) {
+            std::uint32_t r = varRef(tok.text);
+            advance();
+            std::string op = tok.text;
+            advance();
+            std::uint32_t value;
+            if (op == "=")        value = expression();
+            else if (op == "+=")  value = addNodes(emit(Op::Var, Type::Any, r), expression());
+            else if (op == "-=")  value = emit(Op::Sub, Type::Number, emit(Op::Var, Type::Any, r), expression());
+            else                  value = increment(r, op == "++");
+            s = stmt(StmtOp::Assign, r, value);
+        }
+        else if (isPunct("++") || isPunct("--")) {
+            bool inc = isPunct("++");
+            advance();
+            if (tok.kind != Token::Kind::Ident) throw Unsupported("expected identifier");
+            std::uint32_t r = varRef(tok.text);
+            advance();
+            s = stmt(StmtOp::Assign, r, increment(r, inc));
+        }
+        else if (isIdent("output")) {
+            advance();
+            expect("(");
+            if (tok.kind != Token::Kind::String)
+                throw Unsupported("non-literal output name");
+            std::uint32_t r = ref(tok.text);
+            prog.m_refs[r].isOutput = true;
+            advance();
+            expect(",");
+            std::uint32_t value = expression();
+            expect(")");
+            s = stmt(StmtOp::Output, r, value);
+        }
+        else {
+            s = stmt(StmtOp::Expr, expression());
+        }
+        endOfStatement();
+        return s;
+    }
+
+    /// `x++` / `x--` as a statement: Number(x) ± 1.
+    std::uint32_t increment(std::uint32_t r, bool inc) {
+        std::uint32_t x   = emit(Op::Pos, Type::Number, emit(Op::Var, Type::Any, r));
+        std::uint32_t one = constant(JsValue::fromNumber(1));
+        return inc ? emit(Op::Add, Type::Number, x, one) : emit(Op::Sub, Type::Number, x, one);
+    }
+
+    /// Binary `+` with its result type inferred from the operands.
+    std::uint32_t addNodes(std::uint32_t l, std::uint32_t r) {
+        Type t = (typeOf(l) == Type::String || typeOf(r) == Type::String) ? Type::String
+               : (typeOf(l) == Type::Number && typeOf(r) == Type::Number) ? Type::Number
+               : Type::Any;
+        return emit(Op::Add, t, l, r);
+    }
+
+    /// Accept ';' or an automatically inserted one (line break, '}' or end).
+    void endOfStatement() {
+        if (isPunct(";")) { advance(); return; }
+        if (tok.kind == Token::Kind::End || isPunct("}") || tok.newlineBefore) return;
+        throw Unsupported("unexpected '" + tok.text + "'");
+    }
+
+    Type typeOf(std::uint32_t n) const { return prog.m_nodes[n].type; }
+
+    // expression := or
+    std::uint32_t expression() { return logicalOr(); }
+
+    std::uint32_t logicalOr() {
+        std::uint32_t l = logicalAnd();
+        while (isPunct("||")) {
+            advance();
+            std::uint32_t r = logicalAnd();
+            l = emit(Op::Or, typeOf(l) == typeOf(r) ? typeOf(l) : Type::Any, l, r);
+        }
+        return l;
+    }
+
+    std::uint32_t logicalAnd() {
+        std::uint32_t l = equality();
+        while (isPunct("&&")) {
+            advance();
+            std::uint32_t r = equality();
+            l = emit(Op::And, typeOf(l) == typeOf(r) ? typeOf(l) : Type::Any, l, r);
+        }
+        return l;
+    }
+
+    std::uint32_t equality() {
+        std::uint32_t l = relational();
+        while (true) {
+            Op op;
+            if      (isPunct("=="))  op = Op::Eq;
+            else if (isPunct("!="))  op = Op::Ne;
+            else if (isPunct("===")) op = Op::StrictEq;
+            else if (isPunct("!==")) op = Op::StrictNe;
+            else return l;
+            advance();
+            l = emit(op, Type::Bool, l, relational());
+        }
+    }
+
+    std::uint32_t relational() {
+        std::uint32_t l = additive();
+        while (true) {
+            Op op;
+            if      (isPunct("<"))  op = Op::Lt;
+            else if (isPunct("<=")) op = Op::Le;
+            else if (isPunct(">"))  op = Op::Gt;
+            else if (isPunct(">=")) op = Op::Ge;
+            else return l;
+            advance();
+            l = emit(op, Type::Bool, l, additive());
+        }
+    }
+
+    std::uint32_t additive() {
+        std::uint32_t l = multiplicative();
+        while (isPunct("+") || isPunct("-")) {
+            bool plus = isPunct("+");
+            advance();
+            std::uint32_t r = multiplicative();
+            l = plus ? addNodes(l, r) : emit(Op::Sub, Type::Number, l, r);
+        }
+        return l;
+    }
+
+    std::uint32_t multiplicative() {
+        std::uint32_t l = unary();
+        while (true) {
+            Op op;
+            if      (isPunct("*")) op = Op::Mul;
+            else if (isPunct("/")) op = Op::Div;
+            else if (isPunct("%")) op = Op::Mod;
+            else return l;
+            advance();
+            l = emit(op, Type::Number, l, unary());
+        }
+    }
+
+    std::uint32_t unary() {
+        if (isPunct("!")) { advance(); return emit(Op::Not, Type::Bool,   unary()); }
+        if (isPunct("-")) { advance(); return emit(Op::Neg, Type::Number, unary()); }
+        if (isPunct("+")) { advance(); return emit(Op::Pos, Type::Number, unary()); }
+        return primary();
+    }
+
+    /// Argument of valueof()/defined(): must be a string literal.
+    std::uint32_t nameArgument() {
+        expect("(");
+        if (tok.kind != Token::Kind::String)
+            throw Unsupported("non-literal name argument");
+        std::uint32_t r = ref(tok.text);
+        prog.m_refs[r].isInput = true;
+        advance();
+        expect(")");
+        return r;
+    }
+
+    std::uint32_t primary() {
+        switch (tok.kind) {
+        case Token::Kind::Number: {
+            double d = tok.number;
+            advance();
+            return constant(JsValue::fromNumber(d));
+        }
+        case Token::Kind::String: {
+            std::string s = tok.text;
+            advance();
+            return constant(JsValue::fromString(std::move(s)));
+        }
+        case Token::Kind::Ident: {
+            std::string id = tok.text;
+            advance();
+            if (id == "true")    return constant(JsValue::fromBool(true));
+            if (id == "false")   return constant(JsValue::fromBool(false));
+            if (id == "valueof") {
+                return vars ? emit(Op::ValueofLoose, Type::Any, nameArgument())
+                            : emit(Op::Valueof, Type::String, nameArgument());
+            }
+            if (id == "defined") return emit(Op::Defined, Type::Bool, nameArgument());
+            if (id == "atoi") {
+                expect("(");
+                std::uint32_t arg = expression();
+                expect(")");
+                return emit(vars ? Op::AtoiLoose : Op::Atoi, Type::Number, arg);
+            }
+            if (id == "elapsed" && vars) {
+                expect("(");
+                expect(")");
+                return emit(Op::Elapsed, Type::Number);
+            }
+            if (isPunct("(") || id == "if" || id == "else" || id == "output")
+                throw Unsupported("identifier '" + id + "'");
+            return emit(Op::Var, Type::Any, varRef(id));
+        }
+        case Token::Kind::Punct:
+            if (isPunct("(")) {
+                advance();
+                std::uint32_t e = expression();
+                expect(")");
+                return e;
+            }
+            throw Unsupported("unexpected '" + tok.text + "'");
+        case Token::Kind::End:
+        default:
+            throw Unsupported("unexpected end of expression");
+        }
+    }
+};
+
+std::optional<Program> Program::compileGuard(const std::string& src, std::string* why) {
+    try {
+        Program prog;
+        Compiler c(prog, src);
+        prog.m_root = c.expression();
+        if (c.isPunct(";")) c.advance();   // `return <expr>;;` is valid JS too
+        if (c.tok.kind != Token::Kind::End)
+            throw Unsupported("trailing '" + c.tok.text + "'");
+        return prog;
+    }
+    catch (const Unsupported& e) {
+        if (why) *why = e.what();
+        return std::nullopt;
+    }
+}
+
+std::optional<Program> Program::compileAction(const std::string& src,
+                                              const VarSlots& vars,
+                                              std::string* why)
+{
+    try {
+        Program prog;
+        prog.m_action = true;
+        Compiler c(prog, src, &vars);
+        prog.m_root = c.block(false);
+        return prog;
+    }
+    catch (const Unsupported& e) {
+        if (why) *why = e.what();
+        return std::nullopt;
+    }
+}
+
+void Program::bind(IOSlots& inputs, const VarSlots& vars, IOSlots* outputs) {
+    for (auto& r : m_refs) {
+        if (r.isInput || !m_action) r.input = inputs.declare(r.name);
+        if (r.isOutput && outputs)  r.output = outputs->declare(r.name);
+        r.var = vars.find(r.name);
+    }
+    m_bound = true;
+}
+
+/**
+ * Executes the statements with an overlay holding the values assigned so
+ * far (reads see them, as they would see JS-side ctx.vars), then commits
+ * the assigned variables converted to their declared types.
+ */
+void Program::run(Context& ctx) const {
+    thread_local std::vector<JsValue>      overlay;
+    thread_local std::vector<std::uint8_t> written;
+    overlay.resize(m_refs.size());
+    written.assign(m_refs.size(), 0);
+
+    Env env{ctx.vars, ctx.inputs, ctx.stateSince, ctx.now, overlay.data(), written.data()};
+    exec(m_root, env, ctx);
+
+    for (std::size_t i = 0; i < m_refs.size(); ++i) {
+        if (!written[i]) continue;
+        const SymbolId id = m_refs[i].var;
+        const JsValue& v  = overlay[i];
+        switch (ctx.vars.type(id)) {
+        case Variable::Type::Int: {
+            double d = toNumber(v);
+            int n = std::isnan(d) ? 0
+                  : d >= static_cast<double>(INT_MAX) ? INT_MAX
+                  : d <= static_cast<double>(INT_MIN) ? INT_MIN
+                  : static_cast<int>(d);
+            ctx.vars.set(id, n);
+            break;
+        }
+        case Variable::Type::Double:
+            ctx.vars.set(id, toNumber(v));
+            break;
+        case Variable::Type::String:
+        default:
+            ctx.vars.set(id, toString(v));
+            break;
+        }
+    }
+}
+
+void Program::exec(std::uint32_t s, Env& env, Context& ctx) const {
+    const Stmt& st = m_stmts[s];
+    switch (st.op) {
+    case StmtOp::Expr:
+        eval(st.a, env);
+        break;
+    case StmtOp::Assign:
+        env.overlay[st.a] = eval(st.b, env);
+        env.written[st.a] = 1;
+        break;
+    case StmtOp::Output:
+        if (m_bound) ctx.outputs.set(m_refs[st.a].output, toString(eval(st.b, env)));
+        else         ctx.outputs.set(m_refs[st.a].name, toString(eval(st.b, env)));
+        break;
+    case StmtOp::If:
+        if (evalBool(st.a, env))    exec(st.b, env, ctx);
+        else if (st.c != kNoStmt)   exec(st.c, env, ctx);
+        break;
+    case StmtOp::Block:
+        for (std::uint32_t i = 0; i < st.b; ++i)
+            exec(m_blockItems[st.a + i], env, ctx);
+        break;
+    }
+}
+
+bool Program::test(const VarSlots& vars, const IOSlots& inputs) const {
+    return evalBool(m_root, Env{vars, inputs});
+}
+
+// -- Evaluation -----------------------------------------------------------
+
+std::string_view Program::valueofView(const Ref& r, const Env& env,
+                                      std::string& scratch) const
+{
+    // Inputs shadow variables, unknown names read as ""
+    SymbolId in = m_bound ? r.input : env.inputs.find(r.name);
+    if (env.inputs.has(in)) return env.inputs.get(in);
+
+    SymbolId var = m_bound ? r.var : env.vars.find(r.name);
+    if (var == kNoSymbol) return {};
+    if (auto s = std::get_if<std::string>(&env.vars.value(var))) return *s;
+    scratch = toString(JsValue::fromValue(env.vars.value(var)));
+    return scratch;
+}
+
+JsValue Program::readVar(std::uint32_t ref, const Env& env) const {
+    if (env.written && env.written[ref]) return env.overlay[ref];
+    return JsValue::fromValue(env.vars.value(m_refs[ref].var));
+}
+
+bool Program::isDefined(const Ref& r, const Env& env) const {
+    SymbolId in = m_bound ? r.input : env.inputs.find(r.name);
+    if (env.inputs.has(in)) return true;
+    return (m_bound ? r.var : env.vars.find(r.name)) != kNoSymbol;
+}
+
+double Program::evalNumber(std::uint32_t n, const Env& env) const {
+    const Node& node = m_nodes[n];
+    switch (node.op) {
+    case Op::Const:
+        if (node.type == Type::Number) return m_consts[node.a].number;
+        break;
+    case Op::Atoi: {
+        const Node& arg = m_nodes[node.a];
+        std::string scratch;
+        if (arg.op == Op::Valueof)
+            return parseInt10(valueofView(m_refs[arg.a], env, scratch));
+        return parseInt10(toString(eval(node.a, env)));
+    }
+    case Op::AtoiLoose: {
+        double d = parseInt10(toString(eval(node.a, env)));
+        return std::isnan(d) ? 0.0 : d;
+    }
+    case Op::Elapsed:
+        return static_cast<double>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            env.now - env.since).count());
+    case Op::Neg: return -evalNumber(node.a, env);
+    case Op::Pos: return  evalNumber(node.a, env);
+    case Op::Sub: return evalNumber(node.a, env) - evalNumber(node.b, env);
+    case Op::Mul: return evalNumber(node.a, env) * evalNumber(node.b, env);
+    case Op::Div: return evalNumber(node.a, env) / evalNumber(node.b, env);
+    case Op::Mod: return std::fmod(evalNumber(node.a, env), evalNumber(node.b, env));
+    case Op::Add:
+        if (node.type == Type::Number)
+            return evalNumber(node.a, env) + evalNumber(node.b, env);
+        break;
+    default:
+        break;
+    }
+    return toNumber(eval(n, env));
+}
+
+bool Program::evalBool(std::uint32_t n, const Env& env) const {
+    const Node& node = m_nodes[n];
+    // Only meaningful for binary nodes, i.e. the comparison cases below
+    auto numeric = [&] {
+        return m_nodes[node.a].type == Type::Number && m_nodes[node.b].type == Type::Number;
+    };
+    switch (node.op) {
+    case Op::Defined: return isDefined(m_refs[node.a], env);
+    case Op::Not:     return !evalBool(node.a, env);
+    case Op::And:     return evalBool(node.a, env) && evalBool(node.b, env);
+    case Op::Or:      return evalBool(node.a, env) || evalBool(node.b, env);
+    case Op::Eq: case Op::StrictEq:
+        if (numeric()) return evalNumber(node.a, env) == evalNumber(node.b, env);
+        break;
+    case Op::Ne: case Op::StrictNe:
+        if (numeric()) return evalNumber(node.a, env) != evalNumber(node.b, env);
+        break;
+    case Op::Lt: if (numeric()) return evalNumber(node.a, env) <  evalNumber(node.b, env); break;
+    case Op::Le: if (numeric()) return evalNumber(node.a, env) <= evalNumber(node.b, env); break;
+    case Op::Gt: if (numeric()) return evalNumber(node.a, env) >  evalNumber(node.b, env); break;
+    case Op::Ge: if (numeric()) return evalNumber(node.a, env) >= evalNumber(node.b, env); break;
+    default:
+        if (node.type == Type::Number) {
+            double d = evalNumber(n, env);
+            return d != 0 && !std::isnan(d);
+        }
+        break;
+    }
+    return toBool(eval(n, env));
+}
+
+namespace {
+
+bool strictEquals(const JsValue& x, const JsValue& y) {
+    if (x.kind != y.kind) return false;
+    switch (x.kind) {
+    case JsValue::Kind::Undefined: return true;
+    case JsValue::Kind::Bool:      return x.boolean == y.boolean;
+    case JsValue::Kind::Number:    return x.number == y.number;
+    case JsValue::Kind::String:    return x.string == y.string;
+    }
+    return false;
+}
+
+bool looseEquals(const JsValue& x, const JsValue& y) {
+    if (x.kind == y.kind) return strictEquals(x, y);
+    if (x.kind == JsValue::Kind::Undefined || y.kind == JsValue::Kind::Undefined)
+        return false;
+    // Remaining mixes of bool/number/string all compare as numbers
+    return toNumber(x) == toNumber(y);
+}
+
+/// Abstract relational comparison; returns false whenever NaN is involved.
+template<typename Cmp>
+bool relational(const JsValue& x, const JsValue& y, Cmp cmp) {
+    if (x.kind == JsValue::Kind::String && y.kind == JsValue::Kind::String)
+        return cmp(x.string.compare(y.string), 0);
+    return cmp(toNumber(x), toNumber(y));
+}
+
+} // namespace
+
+JsValue Program::eval(std::uint32_t n, const Env& env) const {
+    const Node& node = m_nodes[n];
+    switch (node.op) {
+    case Op::Const:
+        return m_consts[node.a];
+    case Op::Valueof: {
+        std::string scratch;
+        return JsValue::fromString(std::string(valueofView(m_refs[node.a], env, scratch)));
+    }
+    case Op::Defined:
+        return JsValue::fromBool(isDefined(m_refs[node.a], env));
+    case Op::Atoi: case Op::Neg: case Op::Pos:
+    case Op::Sub:  case Op::Mul: case Op::Div: case Op::Mod:
+    case Op::AtoiLoose: case Op::Elapsed:
+        return JsValue::fromNumber(evalNumber(n, env));
+    case Op::Var:
+        return readVar(node.a, env);
+    case Op::ValueofLoose: {
+        // inputs[n] || vars[n] || ""
+        const Ref& r = m_refs[node.a];
+        SymbolId in = m_bound ? r.input : env.inputs.find(r.name);
+        if (env.inputs.has(in) && !env.inputs.get(in).empty())
+            return JsValue::fromString(env.inputs.get(in));
+        if (r.var != kNoSymbol) {
+            JsValue v = readVar(node.a, env);
+            if (toBool(v)) return v;
+        }
+        return JsValue::fromString(std::string());
+    }
+    case Op::Not:
+        return JsValue::fromBool(!evalBool(node.a, env));
+    case Op::Add: {
+        if (node.type == Type::Number)
+            return JsValue::fromNumber(evalNumber(n, env));
+        JsValue l = eval(node.a, env);
+        JsValue r = eval(node.b, env);
+        if (l.kind == JsValue::Kind::String || r.kind == JsValue::Kind::String)
+            return JsValue::fromString(toString(l) + toString(r));
+        return JsValue::fromNumber(toNumber(l) + toNumber(r));
+    }
+    case Op::Eq: case Op::Ne: case Op::StrictEq: case Op::StrictNe:
+    case Op::Lt: case Op::Le: case Op::Gt: case Op::Ge: {
+        if (m_nodes[node.a].type == Type::Number && m_nodes[node.b].type == Type::Number)
+            return JsValue::fromBool(evalBool(n, env));
+        JsValue l = eval(node.a, env);
+        JsValue r = eval(node.b, env);
+        switch (node.op) {
+        case Op::Eq:       return JsValue::fromBool( looseEquals(l, r));
+        case Op::Ne:       return JsValue::fromBool(!looseEquals(l, r));
+        case Op::StrictEq: return JsValue::fromBool( strictEquals(l, r));
+        case Op::StrictNe: return JsValue::fromBool(!strictEquals(l, r));
+        case Op::Lt: return JsValue::fromBool(relational(l, r, [](auto a, auto b) { return a <  b; }));
+        case Op::Le: return JsValue::fromBool(relational(l, r, [](auto a, auto b) { return a <= b; }));
+        case Op::Gt: return JsValue::fromBool(relational(l, r, [](auto a, auto b) { return a >  b; }));
+        default:     return JsValue::fromBool(relational(l, r, [](auto a, auto b) { return a >= b; }));
+        }
+    }
+    case Op::And: {
+        JsValue l = eval(node.a, env);
+        return toBool(l) ? eval(node.b, env) : l;
+    }
+    case Op::Or: {
+        JsValue l = eval(node.a, env);
+        return toBool(l) ? l : eval(node.b, env);
+    }
+    }
+    return JsValue{};
+}
+
+// -- JS conversions -------------------------------------------------------
+
+JsValue JsValue::fromValue(const Value& value) {
+    return std::visit([](auto&& x) -> JsValue {
+        using T = std::decay_t<decltype(x)>;
+        if constexpr (std::is_same_v<T, std::string>) return JsValue::fromString(x);
+        else if constexpr (std::is_same_v<T, bool>)   return JsValue::fromBool(x);
+        else                                          return JsValue::fromNumber(static_cast<double>(x));
+    }, value);
+}
+
+double toNumber(const JsValue& v) {
+    switch (v.kind) {
+    case JsValue::Kind::Bool:   return v.boolean ? 1.0 : 0.0;
+    case JsValue::Kind::Number: return v.number;
+    case JsValue::Kind::String: return stringToNumber(v.string);
+    case JsValue::Kind::Undefined:
+    default:                    return kNaN;
+    }
+}
+
+std::string toString(const JsValue& v) {
+    switch (v.kind) {
+    case JsValue::Kind::Bool:   return v.boolean ? "true" : "false";
+    case JsValue::Kind::Number: return numberToString(v.number);
+    case JsValue::Kind::String: return v.string;
+    case JsValue::Kind::Undefined:
+    default:                    return "undefined";
+    }
+}
+
+bool toBool(const JsValue& v) noexcept {
+    switch (v.kind) {
+    case JsValue::Kind::Bool:   return v.boolean;
+    case JsValue::Kind::Number: return v.number != 0 && !std::isnan(v.number);
+    case JsValue::Kind::String: return !v.string.empty();
+    case JsValue::Kind::Undefined:
+    default:                    return false;
+    }
+}
+
+/**
+ * Follows ECMAScript Number::toString: shortest round-tripping digits,
+ * plain notation for exponents in (-7, 21), exponent notation otherwise.
+ */
+std::string numberToString(double d) {
+    if (std::isnan(d)) return "NaN";
+    if (d == 0)        return "0";
+    if (std::isinf(d)) return d < 0 ? "-Infinity" : "Infinity";
+
+    char buf[40];
+    if (d == std::floor(d) && std::fabs(d) < 1e21) {
+        std::snprintf(buf, sizeof buf, "%.0f", d);
+        return buf;
+    }
+
+    std::string sign = d < 0 ? "-" : "";
+    d = std::fabs(d);
+    for (int prec = 1; prec <= 17; ++prec) {
+        std::snprintf(buf, sizeof buf, "%.*e", prec - 1, d);
+        if (std::strtod(buf, nullptr) == d) break;
+    }
+
+    // buf is "d[.ddd]e±XX": split into significant digits and exponent
+    std::string digits;
+    const char* p = buf;
+    for (; *p && *p != 'e'; ++p)
+        if (std::isdigit(static_cast<unsigned char>(*p))) digits += *p;
+    int exp = std::atoi(p + 1);
+    while (digits.size() > 1 && digits.back() == '0') digits.pop_back();
+
+    const int k = static_cast<int>(digits.size());
+    const int n = exp + 1;
+    if (k <= n && n <= 21) return sign + digits + std::string(n - k, '0');
+    if (0 < n && n <= 21)  return sign + digits.substr(0, n) + "." + digits.substr(n);
+    if (-6 < n && n <= 0)  return sign + "0." + std::string(-n, '0') + digits;
+
+    std::string out = sign + digits.substr(0, 1);
+    if (k > 1) out += "." + digits.substr(1);
+    out += (n - 1 >= 0) ? "e+" : "e-";
+    out += std::to_string(std::abs(n - 1));
+    return out;
+}
+
+double parseInt10(std::string_view s) noexcept {
+    std::size_t i = 0;
+    while (i < s.size() && isJsSpace(s[i])) ++i;
+    bool neg = false;
+    if (i < s.size() && (s[i] == '+' || s[i] == '-')) neg = s[i++] == '-';
+    double d = 0;
+    std::size_t start = i;
+    while (i < s.size() && std::isdigit(static_cast<unsigned char>(s[i])))
+        d = d * 10 + (s[i++] - '0');
+    if (i == start) return kNaN;
+    return neg ? -d : d;
+}
+
+} // namespace core_fsm::native
@@ -0,0 +1,224 @@
+/**
+ * @file   native_script.hpp
+ * @brief  Native (QJSEngine-free) compiler and evaluator for the common
+ *         subset of the inscription language used by FSM guards and
+ *         state entry actions.
+ *
+ * Sources that stay within the subset (string/number/bool literals,
+ * `valueof`, `defined`, `atoi`, arithmetic, comparisons and logical
+ * operators; for actions also variable reads/assignments, `output`,
+ * `elapsed` and `if`/`else`) are compiled into a compact typed AST and
+ * evaluated directly against the automaton's slot storage.  Anything else
+ * is rejected at compile time so the caller can fall back to the
+ * JavaScript engine.
+ *
+ * @author Martin Ševčík (xsevcim00)
+ * @author Jakub Lůčný (xlucnyj00)
+ * @date   2025-05-06
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "slots.hpp"
+#include "context.hpp"
+
+namespace core_fsm::native {
+
+/**
+ * @struct JsValue
+ * @brief Dynamically typed value following JavaScript conversion rules.
+ */
+struct JsValue {
+    /// Runtime type of the value.
+    enum class Kind : std::uint8_t { Undefined, Bool, Number, String };
+
+    Kind        kind{Kind::Undefined}; ///< Active member
+    bool        boolean{false};        ///< Value when kind == Bool
+    double      number{0.0};           ///< Value when kind == Number
+    std::string string;                ///< Value when kind == String
+
+    /** @return A JS number. */
+    static JsValue fromNumber(double d) { JsValue v; v.kind = Kind::Number; v.number = d; return v; }
+    /** @return A JS boolean. */
+    static JsValue fromBool(bool b)     { JsValue v; v.kind = Kind::Bool; v.boolean = b; return v; }
+    /** @return A JS string. */
+    static JsValue fromString(std::string s) { JsValue v; v.kind = Kind::String; v.string = std::move(s); return v; }
+    /** @return The JS counterpart of a variable value. */
+    static JsValue fromValue(const Value& value);
+};
+
+/** @brief JS `Number(v)`. */
+double toNumber(const JsValue& v);
+/** @brief JS `String(v)`. */
+std::string toString(const JsValue& v);
+/** @brief JS `Boolean(v)`. */
+bool toBool(const JsValue& v) noexcept;
+/** @brief JS `String(d)` for a number, e.g. 5000 → "5000", 0.1 → "0.1". */
+std::string numberToString(double d);
+/** @brief JS `parseInt(s, 10)`; NaN if @p s has no leading digits. */
+double parseInt10(std::string_view s) noexcept;
+
+/**
+ * @class Program
+ * @brief A compiled guard expression or entry action.
+ *
+ * Nodes are stored in one flat vector and reference their operands by
+ * index.  Every node carries a statically inferred result type so that the
+ * evaluator can take number/boolean fast paths without boxing into JsValue.
+ * Names used in `valueof`/`defined` are kept in a reference table and can
+ * be resolved to slot ids once with bind().
+ */
+class Program {
+public:
+    /**
+     * @brief Compile a guard expression.
+     *
+     * Guard semantics follow the helpers installed by the transition guard
+     * engine: `valueof` returns the input (or variable) as a string,
+     * `defined` checks inputs and variables, `atoi` is `parseInt(s, 10)`.
+     *
+     * @param src  Guard source, e.g. `atoi(valueof("in")) == 1`.
+     * @param why  Optional out-param receiving the reason for rejection.
+     * @return     The program, or std::nullopt if @p src is outside the subset.
+     */
+    static std::optional<Program> compileGuard(const std::string& src,
+                                               std::string* why = nullptr);
+
+    /**
+     * @brief Compile a state entry action.
+     *
+     * Action semantics follow the helpers installed by script::bindCtx():
+     * `valueof(n)` is `inputs[n] || vars[n] || ""`, `atoi` maps NaN to 0,
+     * bare identifiers read and write variables (`=`, `+=`, `-=`, `++`,
+     * `--` as statements), `output(n, v)` stores
+     * `String(v)` and `elapsed()` is the time spent in the current state.
+     * Assigned variables are converted to their declared type once the
+     * action completes, exactly like script::pullBack().
+     *
+     * @param src   Action source, e.g. `output("out", 1); x = atoi(valueof("in"));`.
+     * @param vars  Variables of the automaton; bare identifiers must name one.
+     * @param why   Optional out-param receiving the reason for rejection.
+     * @return      The program, or std::nullopt if @p src is outside the subset.
+     */
+    static std::optional<Program> compileAction(const std::string& src,
+                                                const VarSlots& vars,
+                                                std::string* why = nullptr);
+
+    /**
+     * @brief Resolve referenced names to slot ids.
+     *
+     * Referenced inputs are declared in @p inputs so that values arriving
+     * later land in the same slots.  Before bind() is called every access
+     * falls back to a lookup by name.
+     *
+     * @param inputs   Input slots of the automaton.
+     * @param vars     Variable slots of the automaton.
+     * @param outputs  Output slots (needed by actions that call `output`).
+     */
+    void bind(IOSlots& inputs, const VarSlots& vars, IOSlots* outputs = nullptr);
+
+    /**
+     * @brief Evaluate the program as a guard.
+     * @param vars    Current variables.
+     * @param inputs  Last-seen inputs.
+     * @return        JS truthiness of the expression value.
+     */
+    bool test(const VarSlots& vars, const IOSlots& inputs) const;
+
+    /**
+     * @brief Run the program as an entry action.
+     *
+     * The program is not modified, so a bound program may run on several
+     * threads at once; ids resolved by bind() must match the layout of
+     * the context's slots.
+     *
+     * @param ctx  Execution context of the state being entered.
+     */
+    void run(Context& ctx) const;
+
+private:
+    /// Operation performed by a node.
+    enum class Op : std::uint8_t {
+        Const, Valueof, Defined, Atoi,
+        Not, Neg, Pos,
+        Add, Sub, Mul, Div, Mod,
+        Lt, Le, Gt, Ge, Eq, Ne, StrictEq, StrictNe,
+        And, Or,
+        Var, ValueofLoose, AtoiLoose, Elapsed   // action dialect only
+    };
+
+    /// Statement kinds of an action.
+    enum class StmtOp : std::uint8_t { Expr, Assign, Output, If, Block };
+
+    /// Statically known result type of a node (Any = decided at runtime).
+    enum class Type : std::uint8_t { Any, Bool, Number, String };
+
+    /// One AST node; @c a / @c b are child node, constant or reference indices.
+    struct Node {
+        Op            op;
+        Type          type;
+        std::uint32_t a;
+        std::uint32_t b;
+    };
+
+    /**
+     * One statement.  Expr: a = node; Assign/Output: a = ref, b = node;
+     * If: a = condition node, b = then, c = else (kNoStmt if absent);
+     * Block: a = first entry in m_blockItems, b = count.
+     */
+    struct Stmt {
+        StmtOp        op;
+        std::uint32_t a;
+        std::uint32_t b;
+        std::uint32_t c;
+    };
+
+    static constexpr std::uint32_t kNoStmt = 0xFFFFFFFFu;
+
+    /// A name used by the program together with its resolved slots.
+    struct Ref {
+        std::string name;
+        SymbolId    input{kNoSymbol};
+        SymbolId    var{kNoSymbol};
+        SymbolId    output{kNoSymbol};
+        bool        isInput{false};   ///< Used by valueof/defined
+        bool        isOutput{false};  ///< Used as output name
+    };
+
+    /// Storage visible to the evaluator.
+    struct Env {
+        const VarSlots&   vars;
+        const IOSlots&    inputs;
+        Clock::time_point since{};           ///< State entry time (actions)
+        Clock::time_point now{};             ///< Current time of the owner (actions)
+        JsValue*          overlay{nullptr};  ///< Per-ref values assigned by the action
+        std::uint8_t*     written{nullptr};  ///< Per-ref flag: overlay entry valid
+    };
+
+    struct Compiler;
+    friend struct Compiler;
+
+    JsValue          eval(std::uint32_t n, const Env& env) const;
+    double           evalNumber(std::uint32_t n, const Env& env) const;
+    bool             evalBool(std::uint32_t n, const Env& env) const;
+    std::string_view valueofView(const Ref& r, const Env& env, std::string& scratch) const;
+    bool             isDefined(const Ref& r, const Env& env) const;
+    JsValue          readVar(std::uint32_t ref, const Env& env) const;
+    void             exec(std::uint32_t stmt, Env& env, Context& ctx) const;
+
+    std::vector<Node>    m_nodes;     ///< Flat AST
+    std::vector<JsValue> m_consts;    ///< Literal pool
+    std::vector<Ref>     m_refs;      ///< Referenced names
+    std::vector<Stmt>    m_stmts;     ///< Action statements
+    std::vector<std::uint32_t> m_blockItems; ///< Statement lists of Block statements
+    std::uint32_t        m_root{0};   ///< Root node (guard) or root Block statement (action)
+    bool                 m_action{false}; ///< Compiled with compileAction()
+    bool                 m_bound{false}; ///< True once bind() resolved m_refs
+};
+
+} // namespace core_fsm::native
@@ -0,0 +1,104 @@
+/**
+ * @file   parker.hpp
+ * @brief  Lightweight park/unpark primitive for a single waiting thread.
+ *
+ * The consumer parks with a timeout; producers unpark it.  Unpark only
+ * enters the kernel when the consumer is actually parked, so a busy
+ * consumer costs producers one atomic exchange.  Uses a futex on Linux and
+ * a mutex/condition variable elsewhere.
+ *
+ * @author Martin Ševčík (xsevcim00)
+ * @author Jakub Lůčný (xlucnyj00)
+ * @date   2025-05-06
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <ctime>
+#else
+#include <condition_variable>
+#include <mutex>
+#endif
+
+namespace core_fsm {
+
+/**
+ * @class Parker
+ * @brief Single-waiter wakeup token.
+ *
+ * The state is EMPTY, PARKED (waiter asleep) or NOTIFIED (a wakeup is
+ * pending).  An unpark() that arrives while nobody is parked leaves the
+ * token behind, so the next park() returns immediately and no wakeup is
+ * ever lost.
+ */
+class Parker {
+public:
+    /**
+     * @brief Block until unpark() is called or @p timeout elapses (one thread only).
+     * @param timeout  Maximum time to wait.
+     */
+    void park(std::chrono::nanoseconds timeout) {
+        // NOTIFIED -> EMPTY: consume the pending wakeup; EMPTY -> PARKED: sleep
+        if (m_state.fetch_sub(1, std::memory_order_acquire) == kNotified) return;
+        if (timeout.count() > 0) wait(timeout);
+        m_state.exchange(kEmpty, std::memory_order_acquire);
+    }
+
+    /** @brief Wake the parked thread, or make its next park() return at once (any thread). */
+    void unpark() {
+        if (m_state.exchange(kNotified, std::memory_order_release) == kParked)
+            wake();
+    }
+
+private:
+    static constexpr std::int32_t kParked   = -1;
+    static constexpr std::int32_t kEmpty    = 0;
+    static constexpr std::int32_t kNotified = 1;
+
+#if defined(__linux__)
+    static_assert(sizeof(std::atomic<std::int32_t>) == sizeof(std::int32_t),
+                  "futex needs a plain 32-bit word");
+
+    void wait(std::chrono::nanoseconds timeout) {
+        const auto secs = std::chrono::duration_cast<std::chrono::seconds>(timeout);
+        timespec ts;
+        ts.tv_sec  = static_cast<time_t>(secs.count());
+        ts.tv_nsec = static_cast<long>((timeout - secs).count());
+        // Returns at once if the state is no longer PARKED
+        syscall(SYS_futex, reinterpret_cast<std::int32_t*>(&m_state),
+                FUTEX_WAIT_PRIVATE, kParked, &ts, nullptr, 0);
+    }
+
+    void wake() {
+        syscall(SYS_futex, reinterpret_cast<std::int32_t*>(&m_state),
+                FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+    }
+#else
+    void wait(std::chrono::nanoseconds timeout) {
+        std::unique_lock<std::mutex> lk(m_mtx);
+        m_cv.wait_for(lk, timeout, [&] {
+            return m_state.load(std::memory_order_acquire) != kParked;
+        });
+    }
+
+    void wake() {
+        { std::lock_guard<std::mutex> lk(m_mtx); }
+        m_cv.notify_one();
+    }
+
+    std::mutex              m_mtx;  ///< Protects the sleep (non-Linux)
+    std::condition_variable m_cv;   ///< Sleep/wake (non-Linux)
+#endif
+
+    std::atomic<std::int32_t> m_state{kEmpty}; ///< EMPTY, PARKED or NOTIFIED
+};
+
+} // namespace core_fsm
@@ -0,0 +1,127 @@
+/**
+ * @file   reactor.cpp
+ * @brief  Implements Reactor: ready tracking, deadline wheel and the
+ *         wait/step round.
+ *
+ * @author Martin Ševčík (xsevcim00)
+ * @author Jakub Lůčný (xlucnyj00)
+ * @date   2025-05-06
+ */
+
+#include "reactor.hpp"
+#include <thread>
+
+namespace core_fsm {
+
+// Adopt an automaton and route its wakeups to the ready ring
+std::size_t Reactor::add(std::unique_ptr<Automaton> fsm) {
+    const std::size_t id = m_slots.size();
+    fsm->setWakeHandler([this, id] { markReady(id); });
+    fsm->setFullHandler([this, id] { drainFull(id); });
+    auto slot = std::make_unique<Slot>();
+    slot->fsm = std::move(fsm);
+    m_slots.push_back(std::move(slot));
+    return id;
+}
+
+// Size the ready ring to hold every automaton and queue them all once.
+// One spare slot: the id being stepped still occupies its slot while the
+// step may queue that automaton again
+void Reactor::start() {
+    m_ready = std::make_unique<MpscRing<std::size_t>>(m_slots.size() + 1);
+    for (std::size_t id = 0; id < m_slots.size(); ++id)
+        markReady(id);
+}
+
+/**
+ * Queue automaton @p id unless it is queued already.  The flag keeps every
+ * id in the ring at most once, so the ring never fills up.  Only wakeups
+ * from other threads need to interrupt the loop's wait.
+ */
+void Reactor::markReady(std::size_t id) {
+    if (!m_ready) return;   // Not started: start() queues everything
+    Slot& s = *m_slots[id];
+    if (s.ready.exchange(true, std::memory_order_acq_rel)) return;
+    m_ready->tryPush([id](std::size_t& out) { out = id; });
+    if (t_running != this) m_loop.wake();
+}
+
+/**
+ * An injection found the input queue of @p id full.  On the loop thread
+ * nobody else would drain it, so step the automaton right here (it stays
+ * queued if it was, the later step is then just empty); elsewhere wait
+ * for the loop as any producer does.
+ */
+void Reactor::drainFull(std::size_t id) {
+    Slot& s = *m_slots[id];
+    if (t_running == this && m_ready && !s.stepping) {
+        stepOne(id, Scheduler::Clock::now());
+        return;
+    }
+    markReady(id);
+    std::this_thread::yield();
+}
+
+// Step one automaton and re-arm its wakeup if the deadline moved
+std::size_t Reactor::stepOne(std::size_t id, Scheduler::TimePoint now) {
+    Slot& s = *m_slots[id];
+    Automaton& fsm = *s.fsm;
+    s.stepping = true;
+    if (!s.started) {
+        fsm.start();
+        s.started = true;
+    }
+    const std::size_t handled = fsm.step(now);
+    s.stepping = false;
+    ++m_stats.steps;
+    m_stats.events += handled;
+
+    const auto deadline = fsm.nextDeadline();
+    if (deadline != s.armed) {
+        // Without a deadline an older wakeup may still fire: an empty step
+        if (deadline) m_timers.armAt(id, *deadline);
+        s.armed = deadline;
+    }
+    return handled;
+}
+
+std::size_t Reactor::runOnce(std::chrono::milliseconds maxWait) {
+    const Reactor* outer = t_running;
+    t_running = this;
+
+    // Wait for I/O, unless something is ready already, at most until the
+    // earliest deadline (rounded up: waking early would only spin)
+    std::chrono::milliseconds timeout = maxWait;
+    if (!m_ready->empty()) {
+        timeout = std::chrono::milliseconds(0);
+    }
+    else if (auto at = m_timers.nextExpiry()) {
+        auto until = std::chrono::ceil<std::chrono::milliseconds>(*at - Scheduler::Clock::now());
+        if (until.count() < 0) until = std::chrono::milliseconds(0);
+        if (timeout.count() < 0 || until < timeout) timeout = until;
+    }
+    m_loop.runOnce(timeout);
+
+    // Then step everything that is ready, on one clock reading
+    const auto t0 = Scheduler::Clock::now();
+    for (std::size_t id : m_timers.popExpired(t0))
+        markReady(id);
+
+    std::size_t handled = 0;
+    m_ready->drain([&](std::size_t id) {
+        // Clear first: an input queued during the step marks it ready again
+        m_slots[id]->ready.exchange(false, std::memory_order_acq_rel);
+        handled += stepOne(id, t0);
+    }, m_ready->capacity());
+    m_stats.busy += Scheduler::Clock::now() - t0;
+
+    t_running = outer;
+    return handled;
+}
+
+void Reactor::run() {
+    while (!stopped())
+        runOnce();
+}
+
+} // namespace core_fsm
@@ -0,0 +1,116 @@
+/**
+ * @file   reactor.hpp
+ * @brief  Runs many automata, their timers and their I/O on one thread.
+ *
+ * The single-threaded counterpart of AutomatonHost: automata are stepped
+ * by the same thread that waits on their channels (an io_bridge::EventLoop),
+ * so an input read from a socket is handled without crossing threads.
+ *
+ * @author Martin Ševčík (xsevcim00)
+ * @author Jakub Lůčný (xlucnyj00)
+ * @date   2025-05-06
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+#include "automaton.hpp"
+#include "mpsc_queue.hpp"
+#include "scheduler.hpp"
+#include "io/event_loop.hpp"
+
+namespace core_fsm {
+
+/**
+ * @class Reactor
+ * @brief Steps automata from the thread that runs its event loop.
+ *
+ * Register channel descriptors on loop(); their handlers inject inputs,
+ * which marks the automaton ready, and the ready automata are stepped
+ * right after the handlers return.  One wheel holds the next deadline of
+ * every automaton and bounds the loop's wait.  Inputs may also be injected
+ * from other threads: the automaton is marked ready and the loop woken.
+ * An injection on the loop thread that finds the input queue full steps
+ * that automaton at once instead of waiting for the loop.
+ */
+class Reactor {
+public:
+    /// Work done since start().
+    struct Stats {
+        std::uint64_t            steps{0};  ///< step() calls
+        std::uint64_t            events{0}; ///< Inputs and timers handled
+        std::chrono::nanoseconds busy{0};   ///< Time spent inside step()
+    };
+
+    Reactor() = default;
+
+    Reactor(const Reactor&) = delete;
+    Reactor& operator=(const Reactor&) = delete;
+
+    /**
+     * @brief Take ownership of a fully built automaton (before start()).
+     * @param fsm  The automaton; its wake handler is replaced by the reactor.
+     * @return     Id of the automaton within the reactor.
+     */
+    std::size_t add(std::unique_ptr<Automaton> fsm);
+
+    /** @return Number of automata. */
+    std::size_t size() const noexcept { return m_slots.size(); }
+
+    /** @return Automaton @p id (inject inputs through it). */
+    Automaton& automaton(std::size_t id) { return *m_slots[id]->fsm; }
+
+    /** @return The event loop; add channel descriptors and signals here. */
+    io_bridge::EventLoop& loop() noexcept { return m_loop; }
+
+    /** @brief Make every automaton enter its initial state on the first round. */
+    void start();
+
+    /**
+     * @brief One round: wait for I/O or a deadline, then step what is ready.
+     * @param maxWait  Longest wait; negative waits for the next event or deadline.
+     * @return         Number of inputs and timers handled.
+     */
+    std::size_t runOnce(std::chrono::milliseconds maxWait = std::chrono::milliseconds(-1));
+
+    /** @brief Call runOnce() until stop(). */
+    void run();
+
+    /** @brief Make run() return (any thread). */
+    void stop() noexcept { m_loop.stop(); }
+
+    /** @return True once stop() was called. */
+    bool stopped() const noexcept { return m_loop.stopped(); }
+
+    /** @return Counters since start() (loop thread only). */
+    Stats stats() const noexcept { return m_stats; }
+
+private:
+    struct Slot {
+        std::unique_ptr<Automaton>          fsm;
+        std::atomic<bool>                   ready{false};  ///< Queued in m_ready
+        bool                                started{false};
+        bool                                stepping{false};   ///< Inside stepOne()
+        std::optional<Scheduler::TimePoint> armed;         ///< Wakeup last armed
+    };
+
+    void markReady(std::size_t id);
+    void drainFull(std::size_t id);
+    std::size_t stepOne(std::size_t id, Scheduler::TimePoint now);
+
+    /// Reactor whose loop the current thread is running (null if none)
+    static inline thread_local const Reactor* t_running;
+
+    std::vector<std::unique_ptr<Slot>>        m_slots;   // Automata
+    std::unique_ptr<MpscRing<std::size_t>>    m_ready;   // Ids to step; each at most once
+    Scheduler                                 m_timers{Scheduler::Backend::Wheel}; // Next deadline per automaton
+    io_bridge::EventLoop                      m_loop;    // Channels, signals, wakeups
+    Stats                                     m_stats;
+};
+
+} // namespace core_fsm
@@ -2,9 +2,9 @@
  * @file   scheduler.hpp
  * @brief  A simple scheduler for delayed FSM transitions.
  *
- * Provides the Scheduler class, which maintains a min-heap of timers
- * to arm, query, and pop delayed transition events in a finite-state
- * machine.
+ * Provides the Scheduler class, which maintains a min-heap (or, selected
+ * at construction, a hierarchical timing wheel) of timers to arm, query,
+ * and pop delayed transition events in a finite-state machine.
  *
  * @author Martin Ševčík (xsevcim00)
  * @author Jakub Lůčný (xlucnyj00)
@@ -13,18 +13,29 @@
 
 #pragma once
 
+#include <algorithm>
 #include <chrono>
+#include <cstdint>
 #include <optional>
-#include <queue>
 #include <vector>
+#include "timer_wheel.hpp"
 
 /**
  * @class Scheduler
  * @brief Manages timers for delayed transitions in a Moore FSM.
  *
- * Scheduler allows arming transitions to fire after a specified delay,
- * querying the next timeout, popping all expired timers, and purging
- * timers when entering a new state.
+ * Scheduler allows arming transitions to fire at a given time, querying
+ * the next timeout, and popping all expired timers.
+ *
+ * Timers are invalidated lazily: every timer remembers the state-entry
+ * epoch it was armed in, newEpoch() just bumps the epoch (O(1)), and
+ * entries of older epochs are dropped when they surface.  Each transition
+ * has at most one live timer; arming it again replaces the pending one.
+ * Dead entries are compacted away once they outnumber the live ones.
+ *
+ * Two backends share these semantics: the binary heap (default) and a
+ * TimerWheel, whose arm and cancel are O(1), which pays off with many
+ * pending timers.
  */
 struct Scheduler {
     /// Clock type used for scheduling (steady, monotonic).
@@ -34,20 +45,28 @@ struct Scheduler {
     /// Duration in milliseconds.
     using Milliseconds = std::chrono::milliseconds;
 
+    /// Timer storage used by a scheduler.
+    enum class Backend {
+        Heap,   ///< Binary heap, O(log n) arm/expiry
+        Wheel   ///< TimerWheel, O(1) arm/cancel, amortized O(1) expiry
+    };
+
     /**
      * @struct Timer
      * @brief Internal record of a scheduled transition.
      *
-     * Holds the expiration time and the index of the transition to fire.
+     * Holds the expiration time, the index of the transition to fire and
+     * the arm sequence number that tells live entries from replaced ones.
      */
     struct Timer {
-        TimePoint   at;               ///< When the timer expires
-        std::size_t transitionIndex;  ///< Corresponding transition index
+        TimePoint     at;               ///< When the timer expires
+        std::size_t   transitionIndex;  ///< Corresponding transition index
+        std::uint64_t seq;              ///< Arm sequence number
     };
 
     /**
      * @struct Compare
-     * @brief Comparator to turn std::priority_queue into a min-heap.
+     * @brief Comparator to turn the heap into a min-heap.
      *
      * Returns true if a's expiration is later than b's, so the earliest
      * Timer is at the top of the heap.
@@ -59,30 +78,229 @@ struct Scheduler {
     };
 
 private:
-    /// Min-heap of pending timers (earliest expiration at top).
-    std::priority_queue<Timer, std::vector<Timer>, Compare> timers_;
+    /// Latest arm of one transition.
+    struct Armed {
+        std::uint64_t      epoch{0};                      ///< Epoch it was armed in
+        std::uint64_t      seq{0};                        ///< Live entry's sequence, 0 = none
+        TimePoint          at{};                          ///< Deadline of the live entry
+        TimePoint          from{};                        ///< When its countdown started
+        TimePoint          firedAt{};                     ///< Deadline it last fired at
+        bool               fired{false};                  ///< Fired during @c epoch
+        TimerWheel::Handle handle{TimerWheel::kNoHandle}; ///< Wheel node (Backend::Wheel)
+    };
+
+    /// Dead entries tolerated before compaction is considered.
+    static constexpr std::size_t kCompactMin = 64;
+
+    /// Selected timer storage.
+    Backend backend_;
+    /// Min-heap of timers (earliest expiration at front).
+    std::vector<Timer> timers_;
+    /// Timing wheel of timers (Backend::Wheel).
+    TimerWheel wheel_;
+    /// Latest arm per transition index.
+    std::vector<Armed> armed_;
+    /// Current state-entry epoch.
+    std::uint64_t epoch_{1};
+    /// Last arm sequence number handed out.
+    std::uint64_t seq_{0};
+    /// Number of live timers.
+    std::size_t live_{0};
+
+    bool isLive(const Armed& a) const noexcept {
+        return a.epoch == epoch_ && a.seq != 0;
+    }
+
+    bool isLive(const Timer& t) const noexcept {
+        const Armed& a = armed_[t.transitionIndex];
+        return isLive(a) && a.seq == t.seq;
+    }
+
+    /// Entries stored in the backend that no longer fire.
+    std::size_t garbage() const noexcept {
+        return (backend_ == Backend::Wheel ? wheel_.size() : timers_.size()) - live_;
+    }
+
+    /// Drop dead entries once they outnumber the live ones.
+    void maybeCompact() {
+        const std::size_t dead = garbage();
+        if (dead < kCompactMin || dead <= live_) return;
+        if (backend_ == Backend::Wheel) {
+            // Each transition has at most one entry, so liveness by index is exact
+            wheel_.removeIf([&](std::size_t i) { return !isLive(armed_[i]); });
+            return;
+        }
+        timers_.erase(std::remove_if(timers_.begin(), timers_.end(),
+                          [&](const Timer& t) { return !isLive(t); }),
+                      timers_.end());
+        std::make_heap(timers_.begin(), timers_.end(), Compare{});
+    }
+
+    /// Pop dead entries off the front so it holds the earliest live timer.
+    void dropDeadFront() {
+        if (backend_ == Backend::Wheel) {
+            while (auto e = wheel_.front()) {
+                if (isLive(armed_[e->transition])) break;
+                wheel_.cancel(e->handle);
+            }
+            return;
+        }
+        while (!timers_.empty() && !isLive(timers_.front())) {
+            std::pop_heap(timers_.begin(), timers_.end(), Compare{});
+            timers_.pop_back();
+        }
+    }
+
+    /// Record that the live timer of transition @p i has fired.
+    void markFired(std::size_t i) {
+        Armed& a  = armed_[i];
+        a.seq     = 0;
+        a.fired   = true;
+        a.firedAt = a.at;
+        a.handle  = TimerWheel::kNoHandle;
+        --live_;
+    }
 
 public:
+    /**
+     * @brief Create a scheduler.
+     * @param backend  Timer storage to use.
+     */
+    explicit Scheduler(Backend backend = Backend::Heap) : backend_(backend) {}
+
+    /** @return The timer storage in use. */
+    Backend backend() const noexcept { return backend_; }
+
     /**
      * @brief Arm a transition to fire after a given delay.
      *
      * @param transitionIndex  Index of the transition to schedule.
      * @param delay            Delay from now until firing, in ms.
+     * @param now              Current time (of the owner's time source).
+     */
+    void arm(std::size_t transitionIndex, Milliseconds delay, TimePoint now = Clock::now()) {
+        armFrom(transitionIndex, now, delay);
+    }
+
+    /**
+     * @brief Arm a transition to fire @p delay after @p from.
+     *
+     * Same as armAt(from + delay), but remembers @p from as the start of
+     * the countdown (see armedFrom()), so the caller can re-arm with a new
+     * delay without moving the start.
+     *
+     * @param transitionIndex  Index of the transition to schedule.
+     * @param from             When the countdown started.
+     * @param delay            Delay from @p from until firing.
      */
-    void arm(std::size_t transitionIndex, Milliseconds delay) {
-        timers_.push(Timer{Clock::now() + delay, transitionIndex});
+    void armFrom(std::size_t transitionIndex, TimePoint from, Milliseconds delay) {
+        armAt(transitionIndex, from + delay);
+        armed_[transitionIndex].from = from;
+    }
+
+    /**
+     * @brief Arm a transition to fire at a given time.
+     *
+     * A live timer of the same transition is replaced; re-arming it with
+     * an unchanged deadline is a no-op.
+     *
+     * @param transitionIndex  Index of the transition to schedule.
+     * @param at               Expiration time.
+     */
+    void armAt(std::size_t transitionIndex, TimePoint at) {
+        if (armed_.size() <= transitionIndex) armed_.resize(transitionIndex + 1);
+        Armed& a = armed_[transitionIndex];
+
+        if (isLive(a)) {
+            if (a.at == at) return;
+        } else {
+            ++live_;
+        }
+        if (a.epoch != epoch_) a.fired = false;
+
+        // Retire the previous entry: the wheel can unlink it right away,
+        // a heap entry simply stops matching the new sequence number
+        if (backend_ == Backend::Wheel) wheel_.cancel(a.handle);
+
+        a.epoch = epoch_;
+        a.seq   = ++seq_;
+        a.at    = at;
+        a.from  = at;
+        if (backend_ == Backend::Wheel) {
+            a.handle = wheel_.arm(at, transitionIndex);
+        } else {
+            timers_.push_back(Timer{at, transitionIndex, a.seq});
+            std::push_heap(timers_.begin(), timers_.end(), Compare{});
+        }
+        maybeCompact();
+    }
+
+    /** @return True if @p transitionIndex has a live timer. */
+    bool pending(std::size_t transitionIndex) const noexcept {
+        return transitionIndex < armed_.size() && isLive(armed_[transitionIndex]);
+    }
+
+    /**
+     * @brief Start of the countdown of the live timer of @p transitionIndex.
+     * @return The time passed to arm()/armFrom() (the deadline if it was
+     *         armed with armAt()), or std::nullopt if it is not pending.
+     */
+    std::optional<TimePoint> armedFrom(std::size_t transitionIndex) const noexcept {
+        if (!pending(transitionIndex)) return std::nullopt;
+        return armed_[transitionIndex].from;
+    }
+
+    /**
+     * @brief Deadline at which @p transitionIndex last fired in this epoch.
+     * @return The deadline, or std::nullopt if it has not fired since the
+     *         last newEpoch().
+     */
+    std::optional<TimePoint> firedAt(std::size_t transitionIndex) const noexcept {
+        if (transitionIndex >= armed_.size()) return std::nullopt;
+        const Armed& a = armed_[transitionIndex];
+        if (a.epoch != epoch_ || !a.fired) return std::nullopt;
+        return a.firedAt;
+    }
+
+    /**
+     * @brief Start a new state-entry epoch.
+     *
+     * All timers armed so far become dead in O(1); they are discarded when
+     * they surface or by the next compaction.
+     */
+    void newEpoch() noexcept {
+        ++epoch_;
+        live_ = 0;
+    }
+
+    /** @return The current state-entry epoch. */
+    std::uint64_t epoch() const noexcept { return epoch_; }
+
+    /** @return Number of live timers. */
+    std::size_t size() const noexcept { return live_; }
+
+    /**
+     * @brief Expiration time of the earliest live timer.
+     * @return The deadline, or std::nullopt if no timers are pending.
+     */
+    std::optional<TimePoint> nextExpiry() {
+        dropDeadFront();
+        if (backend_ == Backend::Wheel) return wheel_.earliest();
+        if (timers_.empty()) return std::nullopt;
+        return timers_.front().at;
     }
 
     /**
      * @brief Time until the next timer expires.
      *
+     * @param  now  Current time (of the owner's time source).
      * @return Optional delay until the earliest timer; std::nullopt if
      *         no timers are pending.  If already expired, returns zero.
      */
-    std::optional<Milliseconds> nextTimeout() const {
-        if (timers_.empty()) return std::nullopt;
-        auto now = Clock::now();
-        auto delta = std::chrono::duration_cast<Milliseconds>(timers_.top().at - now);
+    std::optional<Milliseconds> nextTimeout(TimePoint now = Clock::now()) {
+        std::optional<TimePoint> at = nextExpiry();
+        if (!at) return std::nullopt;
+        auto delta = std::chrono::duration_cast<Milliseconds>(*at - now);
         if (delta.count() < 0) return Milliseconds(0);
         return delta;
     }
@@ -91,41 +309,31 @@ public:
      * @brief Pop and retrieve all transition indices whose timers
      *        have expired by the given time.
      *
+     * Dead timers (older epochs, replaced arms) are dropped silently.
+     *
      * @param now  The current time point against which to compare.
      * @return     Vector of transition indices whose timers expired.
      */
     std::vector<std::size_t> popExpired(TimePoint now) {
         std::vector<std::size_t> expired;
-        while (!timers_.empty() && timers_.top().at <= now) {
-            expired.push_back(timers_.top().transitionIndex);
-            timers_.pop();
-        }
-        return expired;
-    }
-
-    /**
-     * @brief Remove timers not originating from the active state.
-     *
-     * When entering a new state, any timers whose source state differs
-     * from `activeState` are purged.  This avoids firing stale transitions.
-     *
-     * @tparam Func  Callable receiving a transitionIndex and returning
-     *               its source-state index.
-     * @param activeState  The index of the newly active state.
-     * @param getSrc       Function mapping transitionIndex → source state.
-     */
-    template<typename Func>
-    void purgeForState(size_t activeState, Func getSrc) {
-        std::vector<Timer> keep;
-        while (!timers_.empty()) {
-            auto t = timers_.top();
-            timers_.pop();
-            if (getSrc(t.transitionIndex) == activeState) {
-                keep.push_back(t);
+        if (backend_ == Backend::Wheel) {
+            std::vector<std::size_t> due;
+            wheel_.popExpired(now, due);
+            for (std::size_t i : due) {
+                if (!isLive(armed_[i])) continue;
+                markFired(i);
+                expired.push_back(i);
             }
+            return expired;
         }
-        for (auto &t : keep) {
-            timers_.push(t);
+        while (!timers_.empty() && timers_.front().at <= now) {
+            Timer t = timers_.front();
+            std::pop_heap(timers_.begin(), timers_.end(), Compare{});
+            timers_.pop_back();
+            if (!isLive(t)) continue;
+            markFired(t.transitionIndex);
+            expired.push_back(t.transitionIndex);
         }
+        return expired;
     }
 };
@@ -14,148 +14,560 @@
 #include <QJSEngine>
 #include <QJSValue>
 #include <QJSValueIterator>
+#include <atomic>
 #include <chrono>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <variant>
+#include <vector>
 
 namespace core_fsm::script {
 
-// -- Shared engine --------------------------------------------------------
+// -- Per-thread engines ---------------------------------------------------
 
-/// Return a singleton QJSEngine for all script evaluations.
+namespace {
+
+/// Engines and their caches owned by one thread.
+struct ThreadEngines {
+    std::unique_ptr<QJSEngine> action;      ///< Entry actions
+    std::unique_ptr<QJSEngine> guard;       ///< Transition guards
+    std::uint64_t              installed[2] = {0, 0}; ///< Id of the JsContext installed as `ctx`
+    std::vector<QJSValue>      functions;   ///< Compiled functions by FunctionId
+    std::vector<std::uint8_t>  compiled;    ///< 1 if functions[id] was compiled
+    QJSValue                   track;       ///< Accessor installer (action engine)
+    QJSValue                   alias;       ///< Global alias installer (action engine)
+
+    // Mirrors of destroyed JsContexts, released by this thread (see ~JsContext())
+    std::mutex                                       retiredMutex;
+    std::vector<std::unique_ptr<JsContext::Mirror>>  retired;
+    std::atomic<bool>                                hasRetired{false};
+    bool                                             exited{false}; ///< Thread has ended
+};
+
+/// This thread's engines (null until first use)
+thread_local ThreadEngines* t_engines = nullptr;
+
+/// Releases what is still retired when the thread ends
+struct ThreadExit {
+    ~ThreadExit() {
+        std::lock_guard<std::mutex> lk(t_engines->retiredMutex);
+        t_engines->exited = true;
+        t_engines->retired.clear();
+    }
+};
+
+/// This thread's engines; deliberately leaked (see engine())
+ThreadEngines& local() {
+    if (!t_engines) {
+        t_engines = new ThreadEngines;
+        static thread_local ThreadExit atExit;
+        (void)atExit;
+    }
+    return *t_engines;
+}
+
+/// A registered function source.
+struct Registered {
+    Dialect dialect;
+    QString source;
+};
+
+std::mutex& registryMutex() {
+    static std::mutex mtx;
+    return mtx;
+}
+
+/// All registered sources by FunctionId (deque: entries never move)
+std::deque<Registered>& registry() {
+    static std::deque<Registered> sources;
+    return sources;
+}
+
+/// Id of each registered (dialect, source), so copies of a model share entries
+std::unordered_map<std::string, FunctionId>& registryIndex() {
+    static std::unordered_map<std::string, FunctionId> index;
+    return index;
+}
+
+/// Source of the next JsContext identity (0 = nothing installed).
+std::atomic<std::uint64_t> g_nextContextId{1};
+
+} // namespace
+
+/// Return this thread's QJSEngine for entry actions, helpers preinstalled.
 QJSEngine& engine() {
-    static QJSEngine eng;
-    return eng;
+    ThreadEngines& t = local();
+    if (!t.action) {
+        t.action = std::make_unique<QJSEngine>();
+        // Utility functions for action scripts; they read the global `ctx`,
+        // which JsContext::install() swaps, so they are compiled only once
+        t.action->evaluate(R"js(
+            function defined(n) { return n in ctx.inputs || n in ctx.vars; }
+            function valueof(n) { return ctx.inputs[n] || ctx.vars[n] || ""; }
+            function atoi(s) { return parseInt(s,10) || 0; }
+            function elapsed() { return ctx.now - ctx.since; }
+            function output(n,v) { ctx.outputs[n] = String(v); }
+        )js");
+    }
+    return *t.action;
 }
 
-// -- Context binding ------------------------------------------------------
+/// Return this thread's QJSEngine for transition guards, helpers preinstalled.
+QJSEngine& guardEngine() {
+    ThreadEngines& t = local();
+    if (!t.guard) {
+        t.guard = std::make_unique<QJSEngine>();
+        /*  Helper functions that will be visible from every guard.
+            -------------------------------------------------------
+            • valueof(name)  – returns **last known value** of an input
+                              OR of a variable (inputs shadow variables).
+            • defined(name)  – true when the symbol is present either in
+                              inputs **or** variables.
+            • atoi(s)        – convenience wrapper around parseInt.
+        */
+        t.guard->evaluate(R"(
+            function valueof(name)
+            {
+                if (Object.prototype.hasOwnProperty.call(ctx.inputs, name))
+                    return String(ctx.inputs[name]);   // any JS primitive → str
 
-/**
- * Bind the C++ FSM Context into the JS global `ctx` object.
- * Exposes inputs, vars, outputs, and the `since` timestamp.
- */
-void bindCtx(QJSEngine& eng, Context& ctx) {
-    // Create top‐level ctx object
-    QJSValue obj = eng.newObject();
-
-    // Populate ctx.inputs
-    QJSValue inObj = eng.newObject();
-    for (const auto& [k, v] : ctx.inputs) {
-        inObj.setProperty(
-            QString::fromStdString(k),
-            QJSValue(QString::fromStdString(v))
-        );
-    }
-    obj.setProperty("inputs", inObj);
-
-    // Populate ctx.vars with correct JS types
-    QJSValue varObj = eng.newObject();
-    for (const auto& kv : ctx.vars) {
-        const auto& key = kv.first;
-        const auto& var = kv.second;
-        QString qname = QString::fromStdString(key);
-
-        std::visit([&varObj, &qname](auto&& x){
-            using T = std::decay_t<decltype(x)>;
-            if constexpr (std::is_same_v<T, int> ||
-                        std::is_same_v<T, double> ||
-                        std::is_same_v<T, bool>) {
-                varObj.setProperty(qname, QJSValue(x));
-            } else {
-                varObj.setProperty(qname, QJSValue(QString::fromStdString(x)));
+                if (Object.prototype.hasOwnProperty.call(ctx.vars, name))
+                    return String(ctx.vars[name]);
+
+                return "";                             // unknown → empty str
             }
-        }, var.value());
+
+            function defined(name)
+            {
+                return Object.prototype.hasOwnProperty.call(ctx.inputs, name) ||
+                       Object.prototype.hasOwnProperty.call(ctx.vars,   name);
+            }
+
+            function atoi(s) { return parseInt(s, 10); }
+        )");
     }
-    obj.setProperty("vars", varObj);
+    return *t.guard;
+}
+
+/// Store @p source under an id (reused for identical sources); compiled lazily per thread.
+FunctionId registerFunction(Dialect dialect, const QString& source) {
+    std::string key(1, dialect == Dialect::Guard ? 'g' : 'a');
+    key += source.toStdString();
 
-    // Create empty ctx.outputs
-    obj.setProperty("outputs", eng.newObject());
+    std::lock_guard<std::mutex> lk(registryMutex());
+    auto [it, added] = registryIndex().try_emplace(std::move(key),
+                           static_cast<FunctionId>(registry().size()));
+    if (added) registry().push_back(Registered{dialect, source});
+    return it->second;
+}
+
+/// Compiled function @p id of this thread, compiling it on first use.
+QJSValue function(FunctionId id) {
+    ThreadEngines& t = local();
+    if (id < t.compiled.size() && t.compiled[id]) return t.functions[id];
 
-    // Compute and set ctx.since (ms since UNIX epoch)
+    Registered src;
     {
-        using steady = std::chrono::steady_clock;
-        using system = std::chrono::system_clock;
-        auto nowSys    = system::now();
-        auto nowSteady = steady::now();
-
-        auto sysEpoch    = nowSys.time_since_epoch();
-        auto steadyEpoch = nowSteady.time_since_epoch();
-        auto offset = sysEpoch 
-                    - std::chrono::duration_cast<system::duration>(steadyEpoch);
-
-        auto sinceDur   = ctx.stateSince.time_since_epoch();
-        auto sinceSys   = std::chrono::duration_cast<system::duration>(sinceDur) + offset;
-        auto ms         = std::chrono::duration_cast<std::chrono::milliseconds>(sinceSys).count();
-
-        obj.setProperty("since", QJSValue(static_cast<double>(ms)));
-    }
-
-    // Install into global scope
-    eng.globalObject().setProperty("ctx", obj);
-
-    // Add utility JS functions for guard/action scripts
-    eng.evaluate(R"js(
-        function defined(n) { return n in ctx.inputs || n in ctx.vars; }
-        function valueof(n) { return ctx.inputs[n] || ctx.vars[n] || ""; }
-        function atoi(s) { return parseInt(s,10) || 0; }
-        function elapsed() { return Date.now() - ctx.since; }
-        function output(n,v) { ctx.outputs[n] = String(v); }
-    )js");
-
-    // Alias each variable as a JS global property for convenience
-    eng.evaluate(R"js(
-        (function(){
-            for (let name in ctx.vars) {
-                Object.defineProperty(this, name, {
-                    get: function() { return ctx.vars[name]; },
-                    set: function(v)  { ctx.vars[name] = v; }
+        std::lock_guard<std::mutex> lk(registryMutex());
+        if (id >= registry().size()) return QJSValue();
+        src = registry()[id];
+    }
+    QJSEngine& eng = (src.dialect == Dialect::Guard) ? guardEngine() : engine();
+    QJSValue fn = eng.evaluate(src.source);
+    if (t.functions.size() <= id) {
+        t.functions.resize(id + 1);
+        t.compiled.resize(id + 1, 0);
+    }
+    t.functions[id] = fn;
+    t.compiled[id]  = 1;
+    return fn;
+}
+
+namespace {
+
+/// Convert a variable value to its JS counterpart.
+QJSValue toJs(const Value& value) {
+    return std::visit([](auto&& x) -> QJSValue {
+        using T = std::decay_t<decltype(x)>;
+        if constexpr (std::is_same_v<T, std::string>)
+            return QJSValue(QString::fromStdString(x));
+        else
+            return QJSValue(x);
+    }, value);
+}
+
+/// Id of the JsContext installed as the global `ctx` of this thread's engine.
+std::uint64_t& installedSlot(Dialect d) {
+    return local().installed[d == Dialect::Guard ? 0 : 1];
+}
+
+/// Milliseconds since the UNIX epoch for a steady-clock time point.
+double toEpochMs(Clock::time_point since) {
+    using steady = std::chrono::steady_clock;
+    using system = std::chrono::system_clock;
+    auto nowSys    = system::now();
+    auto nowSteady = steady::now();
+
+    auto sysEpoch    = nowSys.time_since_epoch();
+    auto steadyEpoch = nowSteady.time_since_epoch();
+    auto offset = sysEpoch
+                - std::chrono::duration_cast<system::duration>(steadyEpoch);
+
+    auto sinceDur   = since.time_since_epoch();
+    auto sinceSys   = std::chrono::duration_cast<system::duration>(sinceDur) + offset;
+    auto ms         = std::chrono::duration_cast<std::chrono::milliseconds>(sinceSys).count();
+    return static_cast<double>(ms);
+}
+
+} // namespace
+
+// -- JsContext ------------------------------------------------------------
+
+/// The JS objects of one JsContext in one engine, with their sync state.
+struct JsContext::Mirror {
+    QJSEngine*           engine{nullptr};    ///< Engine the objects were created in
+    ThreadEngines*       owner{nullptr};     ///< Thread owning that engine
+    std::uint64_t        id{0};              ///< Identity as the installed `ctx`
+    std::uint64_t        epoch{0};           ///< JsContext epoch the objects belong to
+    QJSValue             ctx;                ///< The `ctx` object
+    QJSValue             inputs;             ///< `ctx.inputs`
+    QJSValue             vars;               ///< `ctx.vars` (tracking accessors for actions)
+    QJSValue             store;              ///< Variable values behind `ctx.vars`
+    QJSValue             dirty;              ///< Slot ids assigned since the last pull-back
+    QJSValue             flags;              ///< Per-slot "already on dirty" flags
+    QJSValue             outputs;            ///< `ctx.outputs`
+    const VarSlots*      varSrc{nullptr};    ///< Slots mirrored into `ctx.vars`
+    const IOSlots*       inputSrc{nullptr};  ///< Slots mirrored into `ctx.inputs`
+    std::uint64_t        varGen{0};          ///< VarSlots generation last pushed
+    std::uint64_t        inputGen{0};        ///< IOSlots generation last pushed
+    std::vector<QString> varNames;           ///< Cached JS names per variable slot
+    std::size_t          tracked{0};         ///< Variables with a tracking accessor (actions)
+    std::size_t          aliased{0};         ///< Variables aliased as globals (actions)
+};
+
+namespace {
+
+/// Release the mirrors other threads retired into @p t (owning thread only).
+void releaseRetired(ThreadEngines& t) {
+    std::vector<std::unique_ptr<JsContext::Mirror>> retired;
+    {
+        std::lock_guard<std::mutex> lk(t.retiredMutex);
+        retired.swap(t.retired);
+        t.hasRetired.store(false, std::memory_order_relaxed);
+    }
+}   // Destroyed here, on the engine's thread
+
+} // namespace
+
+JsContext::JsContext(Dialect dialect) noexcept
+: m_dialect(dialect)
+{}
+
+/**
+ * Mirrors of this thread's engines are released right away; the others go
+ * to their owning thread, which releases them on its next script call (or
+ * when it exits).  Freeing them here would race with that thread's engine.
+ */
+JsContext::~JsContext() {
+    for (auto& m : m_mirrors) {
+        ThreadEngines* owner = m->owner;
+        if (owner == t_engines) continue;
+        std::lock_guard<std::mutex> lk(owner->retiredMutex);
+        if (owner->exited) {
+            m.release();   // Thread gone, its engine leaked; so are these values
+            continue;
+        }
+        owner->retired.push_back(std::move(m));
+        owner->hasRetired.store(true, std::memory_order_release);
+    }
+}
+
+QJSEngine& JsContext::engine() const {
+    return m_dialect == Dialect::Guard ? guardEngine() : script::engine();
+}
+
+/**
+ * This thread's mirror, created on first use here and rebuilt after
+ * reset().  Ids are never reused, so no engine is left pointing at a
+ * stale mirror as its installed `ctx`.
+ */
+JsContext::Mirror& JsContext::mirror() {
+    QJSEngine& eng = engine();
+    ThreadEngines& t = local();
+    if (t.hasRetired.load(std::memory_order_acquire)) releaseRetired(t);
+
+    Mirror* m = m_last;
+    if (!m || m->engine != &eng) {
+        m = nullptr;
+        for (auto& p : m_mirrors)
+            if (p->engine == &eng) { m = p.get(); break; }
+        if (!m) {
+            // Stepped by a new thread: the other mirrors stay with their engines
+            m_mirrors.push_back(std::make_unique<Mirror>());
+            m = m_mirrors.back().get();
+            m->engine = &eng;
+            m->owner  = &t;
+            m->epoch  = m_epoch + 1;
+        }
+        m_last = m;
+    }
+    if (m->epoch == m_epoch) return *m;
+
+    // Fresh objects and a fresh identity, so nothing synced or installed
+    // earlier can leak into the next use
+    m->epoch    = m_epoch;
+    m->id       = g_nextContextId.fetch_add(1, std::memory_order_relaxed);
+    m->ctx      = eng.newObject();
+    m->inputs   = eng.newObject();
+    m->outputs  = eng.newObject();
+    m->ctx.setProperty("inputs", m->inputs);
+    m->ctx.setProperty("outputs", m->outputs);
+    m->aliased  = 0;
+    m->varSrc   = nullptr;
+    m->inputSrc = nullptr;
+    m->inputGen = 0;
+    resetVarObjects(*m);
+    return *m;
+}
+
+/**
+ * Create fresh `ctx.vars` objects.  Guards read plain properties; for
+ * actions `ctx.vars` holds tracking accessors over a hidden store and
+ * every first write of a slot appends its id to the dirty list.
+ */
+void JsContext::resetVarObjects(Mirror& m) {
+    QJSEngine& eng = *m.engine;
+    m.vars  = eng.newObject();
+    m.store = (m_dialect == Dialect::Action) ? eng.newObject() : m.vars;
+    m.dirty = eng.newArray();
+    m.flags = eng.newArray();
+    m.ctx.setProperty("vars", m.vars);
+    m.varGen  = 0;
+    m.tracked = 0;
+    m.varNames.clear();
+}
+
+/// JS name of variable slot @p id, converted once.
+const QString& JsContext::varName(Mirror& m, const VarSlots& vars, SymbolId id) {
+    while (m.varNames.size() <= id)
+        m.varNames.push_back(QString::fromStdString(
+            vars.name(static_cast<SymbolId>(m.varNames.size()))));
+    return m.varNames[id];
+}
+
+// Every mirror is rebuilt on its own thread the next time it is used
+void JsContext::reset() noexcept {
+    ++m_epoch;
+}
+
+/**
+ * Push every variable whose stamp is newer than the last synced
+ * generation.  New variables get their write tracker and are aliased as
+ * JS globals (actions only).
+ */
+void JsContext::syncVars(const VarSlots& vars) {
+    Mirror& m = mirror();
+    if (&vars != m.varSrc) {
+        // Another slot store: start over with empty objects
+        if (m.varSrc) resetVarObjects(m);
+        m.varSrc = &vars;
+    }
+    if (vars.generation() == m.varGen) return;
+
+    // Stores go to the backing object, so they do not mark slots dirty
+    for (SymbolId id = 0; id < vars.size(); ++id) {
+        if (vars.stamp(id) > m.varGen)
+            m.store.setProperty(varName(m, vars, id), toJs(vars.value(id)));
+    }
+    m.varGen = vars.generation();
+
+    if (m_dialect != Dialect::Action) return;
+
+    // Install a tracking accessor on ctx.vars for each new variable
+    if (m.tracked < vars.size()) {
+        QJSValue& track = local().track;
+        if (track.isUndefined()) track = m.engine->evaluate(R"js(
+            (function(vars, store, dirty, flags, name, id) {
+                Object.defineProperty(vars, name, {
+                    get: function() { return store[name]; },
+                    set: function(v) {
+                        store[name] = v;
+                        if (!flags[id]) { flags[id] = 1; dirty.push(id); }
+                    },
+                    enumerable: true
                 });
-            }
-        })();
-    )js");
+            })
+        )js");
+        for (; m.tracked < vars.size(); ++m.tracked) {
+            SymbolId id = static_cast<SymbolId>(m.tracked);
+            track.call({ m.vars, m.store, m.dirty, m.flags,
+                         QJSValue(varName(m, vars, id)), QJSValue(id) });
+        }
+    }
+
+    // Alias each new variable as a JS global property for convenience;
+    // the accessors go through the global ctx, so they are defined once
+    // per engine and work for any installed JsContext
+    if (m.aliased < vars.size()) {
+        QJSValue& alias = local().alias;
+        if (alias.isUndefined()) alias = m.engine->evaluate(R"js(
+            (function(){
+                var global = this;
+                return function(name) {
+                    Object.defineProperty(global, name, {
+                        get: function() { return ctx.vars[name]; },
+                        set: function(v)  { ctx.vars[name] = v; },
+                        configurable: true
+                    });
+                };
+            })()
+        )js");
+        for (; m.aliased < vars.size(); ++m.aliased)
+            alias.call({ QJSValue(varName(m, vars, static_cast<SymbolId>(m.aliased))) });
+    }
 }
 
-// -- Pulling results back -----------------------------------------------
+/**
+ * Push every input set or cleared since the last synced generation;
+ * cleared inputs are deleted so `name in ctx.inputs` stays accurate.
+ */
+void JsContext::syncInputs(const IOSlots& inputs) {
+    Mirror& m = mirror();
+    if (&inputs != m.inputSrc) {
+        m.inputSrc = &inputs;
+        m.inputGen = 0;
+    }
+    if (inputs.generation() == m.inputGen) return;
+
+    for (SymbolId id = 0; id < inputs.size(); ++id) {
+        if (inputs.stamp(id) <= m.inputGen) continue;
+        QString qname = QString::fromStdString(inputs.name(id));
+        if (inputs.has(id))
+            m.inputs.setProperty(qname, QJSValue(QString::fromStdString(inputs.get(id))));
+        else
+            m.inputs.deleteProperty(qname);
+    }
+    m.inputGen = inputs.generation();
+}
+
+// `now` is derived from `since` so elapsed() does not depend on when the
+// steady/system offset was sampled (exact under virtual time)
+void JsContext::setTimes(Clock::time_point since, Clock::time_point now) {
+    Mirror& m = mirror();
+    const double sinceMs = toEpochMs(since);
+    const auto   elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - since);
+    m.ctx.setProperty("since", QJSValue(sinceMs));
+    m.ctx.setProperty("now",   QJSValue(sinceMs + static_cast<double>(elapsed.count())));
+}
+
+void JsContext::install() {
+    Mirror& m = mirror();
+    std::uint64_t& current = installedSlot(m_dialect);
+    if (current == m.id) return;
+    m.engine->globalObject().setProperty("ctx", m.ctx);
+    current = m.id;
+}
 
 /**
- * Read back any mutations made in JS to ctx.vars and ctx.outputs,
- * updating the original C++ Context accordingly.
+ * Read back JS mutations of ctx.vars and ctx.outputs.  Only the variable
+ * slots on the dirty list (assigned by the script) are visited; each is
+ * converted and stored only if it differs from what was pushed.
  */
-void pullBack(QJSEngine& eng, Context& ctx) {
-    QJSValue obj    = eng.globalObject().property("ctx");
-
-    // Sync vars: convert JS values to the declared C++ types
-    QJSValue varObj = obj.property("vars");
-    QJSValueIterator it(varObj);
-    while (it.hasNext()) {
-        it.next();
-        std::string name = it.name().toStdString();
-        QJSValue    jsVal = it.value();
-        auto        iter  = ctx.vars.find(name);
-        if (iter == ctx.vars.end()) continue;
-
-        auto& var = iter->second;
-        switch (var.type()) {
+void JsContext::pullBack(Context& ctx) {
+    Mirror* m = &mirror();
+    if (&ctx.vars != m->varSrc) {
+        syncVars(ctx.vars);
+        m = &mirror();
+    }
+
+    // The pushed vars are current unless C++ wrote in the meantime
+    const bool inSync = (ctx.vars.generation() == m->varGen);
+
+    // Sync assigned vars: convert JS values to the declared C++ types
+    const quint32 dirty = m->dirty.property("length").toUInt();
+    for (quint32 i = 0; i < dirty; ++i) {
+        SymbolId id = m->dirty.property(i).toUInt();
+        m->flags.setProperty(id, QJSValue(0));
+        if (id >= ctx.vars.size()) continue;
+
+        const QString& name = varName(*m, ctx.vars, id);
+        QJSValue jsVal = m->store.property(name);
+        if (jsVal.strictlyEquals(toJs(ctx.vars.value(id)))) continue;
+
+        switch (ctx.vars.type(id)) {
             case Variable::Type::Int:
-                var.set(static_cast<int>(jsVal.toNumber()));
+                ctx.vars.set(id, static_cast<int>(jsVal.toNumber()));
                 break;
             case Variable::Type::Double:
-                var.set(jsVal.toNumber());
+                ctx.vars.set(id, jsVal.toNumber());
                 break;
             case Variable::Type::String:
             default:
-                var.set(jsVal.toString().toStdString());
+                ctx.vars.set(id, jsVal.toString().toStdString());
                 break;
         }
+        // Keep JS identical to the converted C++ value
+        m->store.setProperty(name, toJs(ctx.vars.value(id)));
     }
+    if (dirty) m->dirty.setProperty("length", QJSValue(0));
+    if (inSync) m->varGen = ctx.vars.generation();
 
-    // Sync outputs: copy all entries from JS back to C++
-    QJSValue outObj = obj.property("outputs");
-    QJSValueIterator it2(outObj);
+    // Sync outputs: ctx.outputs is emptied after every pull-back, so this
+    // only visits what the script emitted
+    std::vector<QString> emitted;
+    QJSValueIterator it2(m->outputs);
     while (it2.hasNext()) {
         it2.next();
-        std::string name = it2.name().toStdString();
-        std::string val  = it2.value().toString().toStdString();
-        ctx.outputs[name] = val;
+        ctx.outputs.set(it2.name().toStdString(),
+                        it2.value().toString().toStdString());
+        emitted.push_back(it2.name());
     }
+    for (const QString& name : emitted)
+        m->outputs.deleteProperty(name);
+}
+
+// -- Context binding ------------------------------------------------------
+
+namespace {
+
+/// Mirror used when a Context carries no JsContext; rebuilt on every bind.
+JsContext& scratchContext() {
+    static thread_local JsContext scratch{Dialect::Action};
+    return scratch;
+}
+
+JsContext& contextFor(QJSEngine& eng, Context& ctx) {
+    if (ctx.script && &ctx.script->engine() == &eng) return *ctx.script;
+    return scratchContext();
+}
+
+} // namespace
+
+/**
+ * Bind the C++ FSM Context into the JS global `ctx` object.
+ * Exposes inputs, vars, outputs, and the `since` and `now` timestamps.
+ */
+void bindCtx(QJSEngine& eng, Context& ctx) {
+    JsContext& js = contextFor(eng, ctx);
+    if (&js == &scratchContext()) js.reset();
+
+    js.syncInputs(ctx.inputs);
+    js.syncVars(ctx.vars);
+    js.setTimes(ctx.stateSince, ctx.now);
+    js.install();
+}
+
+// -- Pulling results back -----------------------------------------------
+
+/**
+ * Read back any mutations made in JS to ctx.vars and ctx.outputs,
+ * updating the original C++ Context accordingly.
+ */
+void pullBack(QJSEngine& eng, Context& ctx) {
+    contextFor(eng, ctx).pullBack(ctx);
 }
 
 } // namespace core_fsm::script
@@ -3,8 +3,10 @@
  * @brief  Embeds a JavaScript engine for guard and action execution
  *         within the FSM, exposing C++ Context to JS.
  *
- * Provides a shared QJSEngine instance, and utilities to bind the
- * core_fsm::Context into the JS environment and pull back modifications.
+ * Provides per-thread QJSEngine instances with a per-engine cache of
+ * compiled functions, a persistent per-automaton mirror of the slots in JS
+ * (JsContext), and utilities to bind the core_fsm::Context into the JS
+ * environment and pull back modifications.
  *
  * @author Martin Ševčík (xsevcim00)
  * @author Jakub Lůčný (xlucnyj00)
@@ -14,23 +16,148 @@
 #pragma once
 
 #include <QJSEngine>
+#include <QJSValue>
+#include <QString>
+#include <cstdint>
+#include <memory>
+#include <vector>
 #include "context.hpp"
 
 namespace core_fsm::script {
 
 /**
- * @brief Retrieve the shared JavaScript engine instance.
+ * @brief Helper set a script is evaluated with.
  *
- * Ensures a single QJSEngine is used across all script evaluations
- * to reduce overhead and enable caching of parsed scripts.
+ * Guards and entry actions historically see slightly different helpers
+ * (e.g. `atoi` maps NaN to 0 only in actions), so each dialect has its
+ * own engine with its helpers compiled once.
+ */
+enum class Dialect { Guard, Action };
+
+/**
+ * @brief Retrieve the calling thread's JavaScript engine for entry actions.
  *
- * @return Reference to the shared QJSEngine.
+ * QJSEngine is not thread-safe, so every thread gets its own engines,
+ * created on first use with the helpers preinstalled.  They are never
+ * destroyed, since long-lived objects may still hold values of them.
+ *
+ * @return Reference to this thread's action QJSEngine.
  */
 QJSEngine& engine();
 
+/**
+ * @brief Retrieve the calling thread's JavaScript engine for transition guards.
+ * @return Reference to this thread's guard QJSEngine (guard helpers preinstalled).
+ */
+QJSEngine& guardEngine();
+
+/// Id of a function registered with registerFunction().
+using FunctionId = std::uint32_t;
+
+/// FunctionId that refers to no function.
+inline constexpr FunctionId kNoFunction = static_cast<FunctionId>(-1);
+
+/**
+ * @brief Register a function expression for per-engine compilation.
+ *
+ * Compiled values belong to one engine, so models shared across threads
+ * keep the id instead; function() compiles the source in the calling
+ * thread's engine the first time that thread needs it.
+ *
+ * @param dialect  Engine the function runs in.
+ * @param source   Function expression, e.g. `(function(){ return x > 1; })`.
+ * @return         Id to pass to function().
+ */
+FunctionId registerFunction(Dialect dialect, const QString& source);
+
+/**
+ * @brief The compiled function @p id in the calling thread's engine.
+ * @return The function, or a non-callable value if the source does not compile.
+ */
+QJSValue function(FunctionId id);
+
+/**
+ * @class JsContext
+ * @brief Long-lived JS `ctx` object mirroring one automaton's slots.
+ *
+ * The `ctx`, `ctx.inputs`, `ctx.vars` and `ctx.outputs` objects are created
+ * once.  Each sync compares the slots' write stamps with the generation
+ * seen last time and pushes only the slots written since, so the marshaling
+ * cost of a guard or action is proportional to what changed rather than to
+ * the size of the model.
+ *
+ * The way back is write-tracked as well: for actions, `ctx.vars` exposes
+ * accessor properties whose setters record the assigned slot ids, and
+ * pullBack() visits only those.
+ *
+ * JS values belong to the engine that created them, and engines are per
+ * thread.  A hosted automaton may be stepped by different workers, so the
+ * context keeps one mirror per engine; each is only used, and finally
+ * released, on the thread owning its engine.
+ */
+class JsContext {
+public:
+    /** @brief Create an (empty) mirror for the engine of @p dialect. */
+    explicit JsContext(Dialect dialect) noexcept;
+    ~JsContext();
+
+    JsContext(const JsContext&) = delete;
+    JsContext& operator=(const JsContext&) = delete;
+
+    /**
+     * @return The calling thread's engine of this context's dialect.  Used
+     *         from another thread than before, a mirror is built there.
+     */
+    QJSEngine& engine() const;
+
+    /** @brief Push variables written since the last sync into `ctx.vars`. */
+    void syncVars(const VarSlots& vars);
+
+    /** @brief Push inputs set or cleared since the last sync into `ctx.inputs`. */
+    void syncInputs(const IOSlots& inputs);
+
+    /**
+     * @brief Set `ctx.since` and `ctx.now` (ms since the UNIX epoch) from
+     *        steady time points; elapsed() is their difference.
+     */
+    void setTimes(Clock::time_point since, Clock::time_point now);
+
+    /** @brief Make this the engine's global `ctx` (no-op if it already is). */
+    void install();
+
+    /**
+     * @brief Copy JS-side changes of `ctx.vars` and `ctx.outputs` back.
+     *
+     * Only variables assigned since the last pull-back are visited.  They
+     * are converted to their declared types; a converted value
+     * is written back to JS as well so both sides stay identical.  Emitted
+     * outputs are removed from `ctx.outputs` once copied.
+     *
+     * @param ctx  Context whose slots receive the changes.
+     */
+    void pullBack(Context& ctx);
+
+    /** @brief Forget what was synced; the next sync pushes every slot again. */
+    void reset() noexcept;
+
+    struct Mirror;   ///< JS objects and sync state in one engine
+
+private:
+    Mirror& mirror();
+    void resetVarObjects(Mirror& m);
+    static const QString& varName(Mirror& m, const VarSlots& vars, SymbolId id);
+
+    Dialect                              m_dialect;
+    std::uint64_t                        m_epoch{0};       ///< Bumped by reset(); stale mirrors are rebuilt
+    std::vector<std::unique_ptr<Mirror>> m_mirrors;        ///< One per engine used so far
+    Mirror*                              m_last{nullptr};  ///< Mirror of the last call
+};
+
 /**
  * @brief Bind the C++ FSM execution Context into the JS engine.
  *
+ * Uses the persistent JsContext attached to @p ctx when there is one (only
+ * changed slots are pushed); otherwise a scratch context is fully rebuilt.
  * Exposes the following objects to the global JS scope:
  *   - ctx.inputs   : map of input names to string values
  *   - ctx.vars     : map of variable names to their current values
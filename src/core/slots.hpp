@@ -0,0 +1,223 @@
+/**
+ * @file   slots.hpp
+ * @brief  Dense, slot-indexed storage for automaton variables, inputs and
+ *         outputs.  Names are resolved to SymbolIds once (at load time) and
+ *         values live in contiguous arrays indexed by those ids.
+ *
+ * @author Martin Ševčík (xsevcim00)
+ * @author Jakub Lůčný (xlucnyj00)
+ * @date   2025-05-06
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "symbol_table.hpp"
+#include "variable.hpp"
+
+namespace core_fsm {
+
+/**
+ * @class SharedSymbols
+ * @brief Copy-on-write handle to a SymbolTable.
+ *
+ * Copies of a slot storage (e.g. the instances of one compiled model)
+ * share a single name table; a copy only gets its own table when it
+ * interns a name the shared one does not know.
+ */
+class SharedSymbols {
+public:
+    SharedSymbols() : m_table(std::make_shared<SymbolTable>()) {}
+
+    /** @return Id of @p name, interning it (after detaching) if it is new. */
+    SymbolId intern(const std::string& name) {
+        SymbolId id = m_table->find(name);
+        if (id != kNoSymbol) return id;
+        if (m_table.use_count() > 1)
+            m_table = std::make_shared<SymbolTable>(*m_table);
+        return m_table->intern(name);
+    }
+
+    /** @return The shared table. */
+    const SymbolTable& operator*() const noexcept { return *m_table; }
+
+    /** @return The shared table. */
+    const SymbolTable* operator->() const noexcept { return m_table.get(); }
+
+private:
+    std::shared_ptr<SymbolTable> m_table; ///< Never null
+};
+
+/**
+ * @class VarSlots
+ * @brief Internal variables stored by slot id.
+ *
+ * Each variable owns one slot holding its declared type and current value.
+ * The name → slot mapping is fixed once the variables are declared.
+ * Every write stamps the slot with a new generation so that mirrors (e.g.
+ * the JS context) can find the slots changed since they last synced.
+ */
+class VarSlots {
+public:
+    /**
+     * @brief Declare a variable; an already declared name keeps its slot and value.
+     * @param var  Variable providing the name, type and initial value.
+     * @return     Slot id of the variable.
+     */
+    SymbolId add(const Variable& var) {
+        SymbolId id = m_symbols.intern(var.name());
+        if (id == m_values.size()) {
+            m_types.push_back(var.type());
+            m_values.push_back(var.value());
+            m_stamps.push_back(++m_generation);
+        }
+        return id;
+    }
+
+    /** @return Slot id of @p name, or kNoSymbol if it is not a variable. */
+    SymbolId find(const std::string& name) const noexcept { return m_symbols->find(name); }
+
+    /** @return Name of the variable in slot @p id. */
+    const std::string& name(SymbolId id) const noexcept { return m_symbols->name(id); }
+
+    /** @return Declared type of the variable in slot @p id. */
+    Variable::Type type(SymbolId id) const noexcept { return m_types[id]; }
+
+    /** @return Current value of the variable in slot @p id. */
+    const Value& value(SymbolId id) const noexcept { return m_values[id]; }
+
+    /** @brief Store a new value into slot @p id (no type check, like Variable::set). */
+    void set(SymbolId id, Value v) {
+        m_values[id] = std::move(v);
+        m_stamps[id] = ++m_generation;
+    }
+
+    /** @return Generation of the most recent write (0 = never written). */
+    std::uint64_t generation() const noexcept { return m_generation; }
+
+    /** @return Generation at which slot @p id was last written. */
+    std::uint64_t stamp(SymbolId id) const noexcept { return m_stamps[id]; }
+
+    /** @return Number of declared variables. */
+    std::size_t size() const noexcept { return m_values.size(); }
+
+    /** @return True if no variables are declared. */
+    bool empty() const noexcept { return m_values.empty(); }
+
+    /** @return Name ↔ slot table of the variables. */
+    const SymbolTable& symbols() const noexcept { return *m_symbols; }
+
+private:
+    SharedSymbols               m_symbols; ///< Variable name ↔ slot id (shared by copies)
+    std::vector<Variable::Type> m_types;   ///< Declared type per slot
+    std::vector<Value>          m_values;  ///< Current value per slot
+    std::vector<std::uint64_t>  m_stamps;  ///< Generation of the last write per slot
+    std::uint64_t               m_generation{0}; ///< Bumped on every write
+};
+
+/**
+ * @class IOSlots
+ * @brief Input or output values stored by slot id.
+ *
+ * Slots are declared up front for the ports listed in the model; names seen
+ * for the first time at runtime are interned on demand.  A slot is either
+ * set (holding the last-seen value) or unset.  Like VarSlots, every change
+ * (set or unset) stamps the slot with a new generation.
+ */
+class IOSlots {
+public:
+    /**
+     * @brief Intern a port name, creating an unset slot if it is new.
+     * @param name  Port name.
+     * @return      Slot id of the port.
+     */
+    SymbolId declare(const std::string& name) {
+        SymbolId id = m_symbols.intern(name);
+        if (id == m_values.size()) {
+            m_values.emplace_back();
+            m_set.push_back(0);
+            m_stamps.push_back(0);
+        }
+        return id;
+    }
+
+    /** @return Slot id of @p name, or kNoSymbol if it was never declared. */
+    SymbolId find(const std::string& name) const noexcept { return m_symbols->find(name); }
+
+    /** @return Name of the port in slot @p id. */
+    const std::string& name(SymbolId id) const noexcept { return m_symbols->name(id); }
+
+    /** @return True if slot @p id currently holds a value. */
+    bool has(SymbolId id) const noexcept { return id < m_set.size() && m_set[id]; }
+
+    /** @return Value of slot @p id (empty string when unset). */
+    const std::string& get(SymbolId id) const noexcept { return m_values[id]; }
+
+    /** @brief Store @p value into slot @p id and mark it as set. */
+    void set(SymbolId id, const std::string& value) {
+        m_values[id] = value;   // reuses the slot's buffer
+        if (!m_set[id]) { m_set[id] = 1; ++m_count; }
+        m_stamps[id] = ++m_generation;
+    }
+
+    /** @brief Store @p value under @p name, declaring the slot if needed. */
+    SymbolId set(const std::string& name, const std::string& value) {
+        SymbolId id = declare(name);
+        set(id, value);
+        return id;
+    }
+
+    /** @brief Unset every slot; declared names and buffers are kept. */
+    void clear() noexcept {
+        if (m_count == 0) return;
+        for (std::size_t i = 0; i < m_set.size(); ++i) {
+            if (m_set[i]) {
+                m_set[i] = 0;
+                m_values[i].clear();
+                m_stamps[i] = ++m_generation;
+            }
+        }
+        m_count = 0;
+    }
+
+    /** @return Generation of the most recent change (0 = never changed). */
+    std::uint64_t generation() const noexcept { return m_generation; }
+
+    /** @return Generation at which slot @p id last changed. */
+    std::uint64_t stamp(SymbolId id) const noexcept { return m_stamps[id]; }
+
+    /** @return Number of slots currently set. */
+    std::size_t count() const noexcept { return m_count; }
+
+    /** @return True if no slot is set. */
+    bool empty() const noexcept { return m_count == 0; }
+
+    /** @return Number of declared slots (set or not). */
+    std::size_t size() const noexcept { return m_values.size(); }
+
+    /** @return Name ↔ slot table of the ports. */
+    const SymbolTable& symbols() const noexcept { return *m_symbols; }
+
+    /**
+     * @brief Visit every set slot in slot order.
+     * @param fn  Callable taking (const std::string& name, const std::string& value).
+     */
+    template<typename Fn>
+    void forEach(Fn&& fn) const {
+        for (std::size_t i = 0; i < m_values.size(); ++i)
+            if (m_set[i]) fn(m_symbols->name(static_cast<SymbolId>(i)), m_values[i]);
+    }
+
+private:
+    SharedSymbols             m_symbols;  ///< Port name ↔ slot id (shared by copies)
+    std::vector<std::string>  m_values;   ///< Last value per slot
+    std::vector<std::uint8_t> m_set;      ///< 1 if the slot holds a value
+    std::vector<std::uint64_t> m_stamps;  ///< Generation of the last change per slot
+    std::size_t               m_count{0}; ///< Number of set slots
+    std::uint64_t             m_generation{0}; ///< Bumped on every change
+};
+
+} // namespace core_fsm
@@ -45,10 +45,15 @@ makeSnapshot(core_fsm::Automaton const& fsm,
             std::uint64_t seq,
             std::int64_t  now_ms)
 {
-    // Convert unordered_maps to ordered maps for deterministic JSON
-    std::map<std::string,std::string> inputs  (fsm.inputs().begin(),  fsm.inputs().end());
-    std::map<std::string,std::string> vars    (fsm.vars().begin(),    fsm.vars().end());
-    std::map<std::string,std::string> outputs (fsm.outputs().begin(), fsm.outputs().end());
+    // Collect slot storage into ordered maps for deterministic JSON
+    std::map<std::string,std::string> inputs;
+    std::map<std::string,nlohmann::json> vars;
+    std::map<std::string,std::string> outputs;
+    fsm.inputs().forEach([&](const std::string& k, const std::string& v) { inputs.emplace(k, v); });
+    for (SymbolId id = 0; id < fsm.vars().size(); ++id)
+        vars.emplace(fsm.vars().name(id),
+                     std::visit([](auto&& x) -> nlohmann::json { return x; }, fsm.vars().value(id)));
+    fsm.outputs().forEach([&](const std::string& k, const std::string& v) { outputs.emplace(k, v); });
 
     nlohmann::json j = {
         {"type",    "state"},
@@ -0,0 +1,108 @@
+/**
+ * @file   snapshot_record.hpp
+ * @brief  Compact, self-contained copy of one snapshot message, filled by
+ *         the automaton and turned into JSON by whoever sends it.
+ *
+ * Separating the two lets the engine thread stop at a flat copy of the
+ * changed entries while the DOM, the encoding and the socket call happen
+ * elsewhere (see io_bridge::SnapshotSender).
+ *
+ * @author Martin Ševčík (xsevcim00)
+ * @author Jakub Lůčný (xlucnyj00)
+ * @date   2025-05-06
+ */
+
+#pragma once
+
+#include "variable.hpp"
+#include "io/wire_format.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+namespace core_fsm {
+
+/**
+ * @struct SnapshotRecord
+ * @brief One `"state"` or `"delta"` message before encoding.
+ *
+ * Records live in reused slots: clear() only resets the counts, so names
+ * and string values keep their buffers and a steady stream of snapshots
+ * does not allocate.
+ */
+struct SnapshotRecord {
+    /// One input, variable or output
+    struct Entry {
+        std::string name;
+        Value       value;         ///< Inputs and outputs hold a string
+        bool        unset{false};  ///< Port unset since the last message (sent as null)
+    };
+
+    /// Entries of one section; slots past size() are kept for reuse
+    class EntryList {
+    public:
+        void clear() noexcept { m_size = 0; }
+
+        /** @return A fresh entry at the end (possibly a recycled one). */
+        Entry& push() {
+            if (m_size == m_slots.size()) m_slots.emplace_back();
+            return m_slots[m_size++];
+        }
+
+        std::size_t size() const noexcept { return m_size; }
+        const Entry* begin() const noexcept { return m_slots.data(); }
+        const Entry* end() const noexcept { return m_slots.data() + m_size; }
+
+    private:
+        std::vector<Entry> m_slots;
+        std::size_t        m_size{0};
+    };
+
+    bool                  key{true};   ///< Keyframe ("state") or "delta"
+    std::uint64_t         seq{0};
+    std::uint64_t         prev{0};     ///< Message a delta applies to
+    std::int64_t          ts{0};
+    io_bridge::WireFormat format{io_bridge::WireFormat::Json};
+    std::string           state;
+    EntryList             inputs;
+    EntryList             vars;
+    EntryList             outputs;
+
+    /// Forget the entries, keeping their storage
+    void clear() noexcept {
+        inputs.clear();
+        vars.clear();
+        outputs.clear();
+    }
+};
+
+/**
+ * @brief Build the snapshot message described by @p r.
+ *
+ * Sections are JSON objects, so the entries come out sorted by name
+ * whatever order they were recorded in.
+ */
+inline nlohmann::json toJson(const SnapshotRecord& r) {
+    auto section = [](const SnapshotRecord::EntryList& list) {
+        nlohmann::json snap = nlohmann::json::object();
+        for (const auto& e : list)
+            snap[e.name] = e.unset ? nlohmann::json(nullptr)
+                                   : std::visit([](auto&& x) -> nlohmann::json { return x; }, e.value);
+        return snap;
+    };
+
+    nlohmann::json j = {
+        {"type",    r.key ? "state" : "delta"},
+        {"seq",     r.seq},
+        {"ts",      r.ts},
+        {"state",   r.state},
+        {"inputs",  section(r.inputs)},
+        {"vars",    section(r.vars)},
+        {"outputs", section(r.outputs)}
+    };
+    if (!r.key) j["prev"] = r.prev;
+    return j;
+}
+
+} // namespace core_fsm
@@ -0,0 +1,106 @@
+/**
+ * @file   spsc_ring.hpp
+ * @brief  Bounded lock-free single-producer/single-consumer ring buffer.
+ *
+ * Used to hand snapshot records from an automaton to its I/O thread: one
+ * thread pushes, one drains, and neither ever waits for the other.
+ *
+ * @author Martin Ševčík (xsevcim00)
+ * @author Jakub Lůčný (xlucnyj00)
+ * @date   2025-05-06
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+namespace core_fsm {
+
+/**
+ * @class SpscRing
+ * @brief Bounded SPSC queue with preallocated slots.
+ *
+ * Head and tail are plain counters owned by one side each; every side
+ * caches the other's counter and only rereads it when the cached value
+ * says the ring is full (producer) or empty (consumer).  Like MpscRing,
+ * elements are written and read in place, so slots keep their buffers
+ * from one use to the next.
+ *
+ * @tparam T  Slot payload; must be default constructible.
+ */
+template<typename T>
+class SpscRing {
+public:
+    /**
+     * @brief Create a ring.
+     * @param capacity  Number of slots, rounded up to a power of two.
+     */
+    explicit SpscRing(std::size_t capacity) {
+        std::size_t size = 2;
+        while (size < capacity) size <<= 1;
+        m_mask  = size - 1;
+        m_slots = std::make_unique<T[]>(size);
+    }
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    /**
+     * @brief Enqueue one element (producer thread only).
+     * @param write  Callable receiving the slot's T& to fill in.
+     * @return       False if the ring is full.
+     */
+    template<typename Fn>
+    bool tryPush(Fn&& write) {
+        const std::size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_headCache > m_mask) {
+            m_headCache = m_head.load(std::memory_order_acquire);
+            if (tail - m_headCache > m_mask) return false;
+        }
+        write(m_slots[tail & m_mask]);
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Consume ready elements in FIFO order (consumer thread only).
+     * @param read  Callable receiving each slot's T& before it is released.
+     * @param max   Upper bound on elements consumed by this call.
+     * @return      Number of elements consumed.
+     */
+    template<typename Fn>
+    std::size_t drain(Fn&& read, std::size_t max = static_cast<std::size_t>(-1)) {
+        std::size_t head = m_head.load(std::memory_order_relaxed);
+        std::size_t n = 0;
+        while (n < max) {
+            if (head == m_tailCache) {
+                m_tailCache = m_tail.load(std::memory_order_acquire);
+                if (head == m_tailCache) break;
+            }
+            read(m_slots[head & m_mask]);
+            m_head.store(++head, std::memory_order_release);   // Slot free again
+            ++n;
+        }
+        return n;
+    }
+
+    /** @return True if no element is ready (consumer thread only). */
+    bool empty() const noexcept {
+        return m_head.load(std::memory_order_relaxed) == m_tail.load(std::memory_order_acquire);
+    }
+
+    /** @return Number of slots. */
+    std::size_t capacity() const noexcept { return m_mask + 1; }
+
+private:
+    std::unique_ptr<T[]>                 m_slots;        ///< Preallocated slots
+    std::size_t                          m_mask{0};      ///< capacity - 1
+    alignas(64) std::atomic<std::size_t> m_head{0};      ///< Next position to read (consumer)
+    std::size_t                          m_tailCache{0}; ///< Consumer's view of m_tail
+    alignas(64) std::atomic<std::size_t> m_tail{0};      ///< Next position to write (producer)
+    std::size_t                          m_headCache{0}; ///< Producer's view of m_head
+};
+
+} // namespace core_fsm
@@ -18,6 +18,12 @@ State::State(std::string name, ActionFn onEnter)
 , m_onEnter(std::move(onEnter))
 {}
 
+// Construct a State whose on-enter action is a native program.
+State::State(std::string name, native::Program action)
+: m_name(std::move(name))
+, m_nativeAction(std::move(action))
+{}
+
 // Return the state's identifier.
 const std::string& State::name() const noexcept {
     return m_name;
@@ -25,9 +31,19 @@ const std::string& State::name() const noexcept {
 
 // Invoke the on-enter action if one was provided.
 void State::onEnter(Context& ctx) const {
-    if (m_onEnter) {
+    if (m_nativeAction) {
+        m_nativeAction->run(ctx);
+    }
+    else if (m_onEnter) {
         m_onEnter(ctx);
     }
 }
 
+// Resolve the native action's names to slot ids.
+void State::bindSlots(IOSlots& inputs, const VarSlots& vars, IOSlots& outputs) {
+    if (m_nativeAction) {
+        m_nativeAction->bind(inputs, vars, &outputs);
+    }
+}
+
 } // namespace core_fsm
@@ -11,8 +11,10 @@
 
 #include <string>
 #include <functional>
+#include <optional>
 #include "transition.hpp"
 #include "context.hpp"
+#include "native_script.hpp"
 
 namespace core_fsm {
 
@@ -29,7 +31,10 @@ using ActionFn = std::function<void(Context&)>;
  * @brief Represents a state in the finite-state machine.
  *
  * Each State has a unique identifier and an optional on-enter action
- * which is invoked when the FSM transitions into this state.
+ * which is invoked when the FSM transitions into this state.  The action
+ * is either a callback or a natively compiled program; the latter is
+ * bound to the model's slots once (see bindSlots()) and never modified
+ * afterwards, so one State can be shared by many instances.
  */
 class State {
 public:
@@ -41,6 +46,14 @@ public:
      */
     State(std::string name, ActionFn onEnter = {});
 
+    /**
+     * @brief Construct a new State whose entry action runs natively.
+     *
+     * @param name    The unique identifier of the state.
+     * @param action  Action compiled with native::Program::compileAction().
+     */
+    State(std::string name, native::Program action);
+
     /**
      * @brief Get the state's identifier.
      * @return Reference to the state's name string.
@@ -54,9 +67,18 @@ public:
      */
     void onEnter(Context& ctx) const;
 
+    /**
+     * @brief Resolve names used by a native action to the automaton's slots.
+     * @param inputs   Input slots (referenced inputs are declared).
+     * @param vars     Variable slots.
+     * @param outputs  Output slots (outputs written by the action are declared).
+     */
+    void bindSlots(IOSlots& inputs, const VarSlots& vars, IOSlots& outputs);
+
 private:
-    std::string m_name;    ///< Unique state name
-    ActionFn    m_onEnter; ///< Entry action callback (may be empty)
+    std::string                    m_name;          ///< Unique state name
+    ActionFn                       m_onEnter;       ///< Entry action callback (may be empty)
+    std::optional<native::Program> m_nativeAction;  ///< Natively compiled entry action
 };
 
 } // namespace core_fsm
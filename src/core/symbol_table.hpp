@@ -0,0 +1,81 @@
+/**
+ * @file   symbol_table.hpp
+ * @brief  Declares SymbolTable, a small name interning table that maps
+ *         model identifiers (trigger names, variables, I/O ports) to
+ *         dense integer ids.
+ *
+ * @author Martin Ševčík (xsevcim00)
+ * @author Jakub Lůčný (xlucnyj00)
+ * @date   2025-05-06
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace core_fsm {
+
+/**
+ * @typedef SymbolId
+ * @brief Dense integer id assigned to an interned name.
+ */
+using SymbolId = std::uint32_t;
+
+/// Id returned by SymbolTable::find() for names that were never interned.
+inline constexpr SymbolId kNoSymbol = std::numeric_limits<SymbolId>::max();
+
+/**
+ * @class SymbolTable
+ * @brief Interns strings into consecutive ids starting at zero.
+ *
+ * Names are hashed once when they are interned (typically while the model
+ * is being built); afterwards the hot paths work with the returned ids.
+ */
+class SymbolTable {
+public:
+    /**
+     * @brief Return the id of @p name, assigning the next free id if needed.
+     * @param name  Name to intern.
+     * @return      Id of the name.
+     */
+    SymbolId intern(const std::string& name) {
+        auto it = m_ids.find(name);
+        if (it != m_ids.end()) return it->second;
+        SymbolId id = static_cast<SymbolId>(m_names.size());
+        m_ids.emplace(name, id);
+        m_names.push_back(name);
+        return id;
+    }
+
+    /**
+     * @brief Look up a name without interning it.
+     * @param name  Name to look up.
+     * @return      Its id, or kNoSymbol if the name is unknown.
+     */
+    SymbolId find(const std::string& name) const noexcept {
+        auto it = m_ids.find(name);
+        return it == m_ids.end() ? kNoSymbol : it->second;
+    }
+
+    /** @return The name that was interned as @p id. */
+    const std::string& name(SymbolId id) const noexcept { return m_names[id]; }
+
+    /** @return Number of interned names. */
+    std::size_t size() const noexcept { return m_names.size(); }
+
+    /** @brief Forget all interned names. */
+    void clear() noexcept {
+        m_ids.clear();
+        m_names.clear();
+    }
+
+private:
+    std::unordered_map<std::string, SymbolId> m_ids;   ///< name → id
+    std::vector<std::string>                  m_names; ///< id → name
+};
+
+} // namespace core_fsm
@@ -0,0 +1,80 @@
+/**
+ * @file   time_source.hpp
+ * @brief  Injectable clock: the real steady clock or a virtual time that
+ *         is advanced explicitly (fast-forward simulation, replay).
+ *
+ * Time points stay std::chrono::steady_clock::time_point everywhere, so
+ * the scheduler and the automaton do not care which source produced them.
+ *
+ * @author Martin Ševčík (xsevcim00)
+ * @author Jakub Lůčný (xlucnyj00)
+ * @date   2025-05-06
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+
+namespace core_fsm {
+
+/**
+ * @class TimeSource
+ * @brief Where an automaton reads the current time from.
+ */
+class TimeSource {
+public:
+    using Clock     = std::chrono::steady_clock;
+    using TimePoint = Clock::time_point;
+
+    virtual ~TimeSource() = default;
+
+    /** @return The current time of this source. */
+    virtual TimePoint now() const noexcept = 0;
+
+    /** @return The process-wide real-time source (steady_clock). */
+    static const TimeSource& steady() noexcept;
+};
+
+/// Real time: steady_clock::now().
+class SteadyTime final : public TimeSource {
+public:
+    TimePoint now() const noexcept override { return Clock::now(); }
+};
+
+inline const TimeSource& TimeSource::steady() noexcept {
+    static const SteadyTime instance;
+    return instance;
+}
+
+/**
+ * @class VirtualTime
+ * @brief Time that only moves when told to.
+ *
+ * Starts at a given point (by default the real now, so time points look
+ * like ordinary steady_clock values) and never moves backwards.  Reading
+ * it is safe from any thread; advance it from the driving thread.
+ */
+class VirtualTime final : public TimeSource {
+public:
+    /** @brief Start virtual time at @p start. */
+    explicit VirtualTime(TimePoint start = Clock::now()) noexcept
+        : m_ticks(start.time_since_epoch().count()) {}
+
+    TimePoint now() const noexcept override {
+        return TimePoint(Clock::duration(m_ticks.load(std::memory_order_acquire)));
+    }
+
+    /** @brief Jump to @p t; earlier points are ignored. */
+    void advanceTo(TimePoint t) noexcept {
+        if (t > now()) m_ticks.store(t.time_since_epoch().count(), std::memory_order_release);
+    }
+
+    /** @brief Move forward by @p d. */
+    void advance(Clock::duration d) noexcept { advanceTo(now() + d); }
+
+private:
+    std::atomic<Clock::rep> m_ticks;   ///< Current time since the clock's epoch
+};
+
+} // namespace core_fsm
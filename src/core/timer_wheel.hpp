@@ -0,0 +1,354 @@
+/**
+ * @file   timer_wheel.hpp
+ * @brief  Hierarchical timing wheel used as an alternative Scheduler backend.
+ *
+ * Timers are kept in intrusive doubly-linked lists hanging off the slots of
+ * a few wheel levels (64 slots each, 1 ms resolution at the lowest level),
+ * so arming and cancelling are O(1) and expiry is amortized O(1) per timer.
+ * An occupancy bitmap per level lets the wheel jump over empty slots
+ * instead of ticking through them one by one.
+ *
+ * @author Martin Ševčík (xsevcim00)
+ * @author Jakub Lůčný (xlucnyj00)
+ * @date   2025-05-06
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <utility>
+#include <vector>
+
+/**
+ * @class TimerWheel
+ * @brief Hierarchical timing wheel of transition timers.
+ *
+ * Level L covers ticks in steps of 64^L ms; a timer is stored on the lowest
+ * level whose current window contains its expiry tick.  When the wheel
+ * reaches the start of a higher-level slot, that slot is cascaded into the
+ * lower levels.  Timers further out than the top level can represent
+ * (2^30 ms, roughly 12 days) wait in an overflow list.
+ */
+class TimerWheel {
+public:
+    /// Clock type used for scheduling (steady, monotonic).
+    using Clock = std::chrono::steady_clock;
+    /// Time point in the above clock.
+    using TimePoint = Clock::time_point;
+    /// Handle identifying one armed timer (stays unique after reuse).
+    using Handle = std::uint64_t;
+
+    /// Handle value that never refers to a timer.
+    static constexpr Handle kNoHandle = std::numeric_limits<Handle>::max();
+
+    /// A pending timer as reported by front().
+    struct Entry {
+        TimePoint   at;          ///< Expiration time
+        std::size_t transition;  ///< Transition index
+        Handle      handle;      ///< Handle for cancel()
+    };
+
+    TimerWheel() : m_origin(Clock::now()) { m_heads.fill(kNil); }
+
+    /**
+     * @brief Arm a timer.
+     * @param at               Expiration time.
+     * @param transitionIndex  Transition to report when it expires.
+     * @return                 Handle usable with cancel().
+     */
+    Handle arm(TimePoint at, std::size_t transitionIndex) {
+        std::uint32_t n = allocNode();
+        Node& node      = m_nodes[n];
+        node.at         = at;
+        node.transition = transitionIndex;
+        node.tick       = std::max(tickOf(at), m_current);
+        place(n);
+
+        if (m_size++ == 0 || (m_nextValid && at < m_nodes[m_next].at)) {
+            m_next      = n;
+            m_nextValid = true;
+        }
+        return handleOf(n);
+    }
+
+    /**
+     * @brief Cancel an armed timer.
+     * @param h  Handle returned by arm().
+     * @return   True if the timer was still pending.
+     */
+    bool cancel(Handle h) {
+        std::uint32_t n = static_cast<std::uint32_t>(h);
+        if (h == kNoHandle || n >= m_nodes.size()) return false;
+        Node& node = m_nodes[n];
+        if (node.bucket == kFree || node.gen != static_cast<std::uint32_t>(h >> 32))
+            return false;
+        release(n);
+        return true;
+    }
+
+    /**
+     * @brief Remove every pending timer whose transition matches @p pred.
+     * @tparam Pred  Callable taking a transition index, returning bool.
+     * @return       Number of timers removed.
+     */
+    template<typename Pred>
+    std::size_t removeIf(Pred pred) {
+        std::size_t removed = 0;
+        for (std::uint32_t n = 0; n < m_nodes.size(); ++n) {
+            if (m_nodes[n].bucket != kFree && pred(m_nodes[n].transition)) {
+                release(n);
+                ++removed;
+            }
+        }
+        return removed;
+    }
+
+    /** @return The earliest pending timer, if any. */
+    std::optional<Entry> front() const {
+        if (m_size == 0) return std::nullopt;
+        if (!m_nextValid) {
+            m_next      = scanEarliest();
+            m_nextValid = true;
+        }
+        const Node& node = m_nodes[m_next];
+        return Entry{node.at, node.transition, handleOf(m_next)};
+    }
+
+    /** @return Expiration time of the earliest pending timer, if any. */
+    std::optional<TimePoint> earliest() const {
+        if (auto e = front()) return e->at;
+        return std::nullopt;
+    }
+
+    /**
+     * @brief Remove all timers expired by @p now, earliest first.
+     * @param now  Current time.
+     * @param out  Receives the transition indices of the expired timers.
+     */
+    void popExpired(TimePoint now, std::vector<std::size_t>& out) {
+        std::uint64_t target = tickOf(now);
+        if (m_size == 0) {
+            // Nothing pending: the wheel may simply jump ahead
+            m_current = std::max(m_current, target);
+            return;
+        }
+        if (target < m_current) target = m_current;
+
+        m_batch.clear();
+        for (;;) {
+            drainCurrent(now, target);
+            if (m_current == target) break;
+
+            // Jump to the next tick where a slot must be cascaded
+            std::uint64_t t = nextEvent();
+            if (t > target) { m_current = target; continue; }
+            m_current = t;
+            cascade(t);
+        }
+        if (m_batch.empty()) return;
+
+        m_nextValid = false;
+        for (const auto& e : m_batch) out.push_back(e.second);
+    }
+
+    /** @return Number of pending timers. */
+    std::size_t size() const noexcept { return m_size; }
+
+    /** @return True if no timer is pending. */
+    bool empty() const noexcept { return m_size == 0; }
+
+private:
+    static constexpr unsigned      kBits   = 6;                  ///< log2(slots per level)
+    static constexpr unsigned      kSlots  = 1u << kBits;        ///< Slots per level
+    static constexpr unsigned      kLevels = 5;                  ///< 64^5 ms ≈ 12.4 days
+    static constexpr std::uint16_t kOverflow = kLevels * kSlots; ///< Bucket of far timers
+    static constexpr std::uint16_t kFree     = kOverflow + 1;    ///< Node is on the free list
+    static constexpr std::uint32_t kNil = std::numeric_limits<std::uint32_t>::max();
+
+    /// One timer; linked into the list of its bucket (or the free list).
+    struct Node {
+        TimePoint     at;                ///< Exact expiration time
+        std::uint64_t tick{0};           ///< Expiration tick (ms since origin)
+        std::size_t   transition{0};     ///< Transition index to report
+        std::uint32_t prev{kNil};        ///< Previous node in the bucket
+        std::uint32_t next{kNil};        ///< Next node in the bucket / free list
+        std::uint32_t gen{0};            ///< Bumped on release, guards stale handles
+        std::uint16_t bucket{kFree};     ///< level * kSlots + slot, kOverflow or kFree
+    };
+
+    Handle handleOf(std::uint32_t n) const noexcept {
+        return (Handle(m_nodes[n].gen) << 32) | n;
+    }
+
+    /// Tick of a time point (whole ms since the wheel was created).
+    std::uint64_t tickOf(TimePoint at) const noexcept {
+        if (at <= m_origin) return 0;
+        return static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::milliseconds>(at - m_origin).count());
+    }
+
+    std::uint32_t allocNode() {
+        if (m_free != kNil) {
+            std::uint32_t n = m_free;
+            m_free = m_nodes[n].next;
+            return n;
+        }
+        m_nodes.emplace_back();
+        return static_cast<std::uint32_t>(m_nodes.size() - 1);
+    }
+
+    /// Unlink @p n from its bucket and return it to the free list.
+    void release(std::uint32_t n) {
+        Node& node = m_nodes[n];
+        if (m_nextValid && m_next == n) m_nextValid = false;
+        unlink(n);
+        node.bucket = kFree;
+        node.prev   = kNil;
+        node.next   = m_free;
+        ++node.gen;
+        m_free = n;
+        --m_size;
+    }
+
+    /// Put node @p n into the bucket matching its tick relative to m_current.
+    void place(std::uint32_t n) {
+        const std::uint64_t e = m_nodes[n].tick;
+        for (unsigned level = 0; level < kLevels; ++level) {
+            const unsigned above = kBits * (level + 1);
+            if ((e >> above) == (m_current >> above)) {
+                const unsigned slot = (e >> (kBits * level)) & (kSlots - 1);
+                link(n, static_cast<std::uint16_t>(level * kSlots + slot));
+                m_occupied[level] |= std::uint64_t{1} << slot;
+                return;
+            }
+        }
+        link(n, kOverflow);
+    }
+
+    void link(std::uint32_t n, std::uint16_t bucket) {
+        Node& node  = m_nodes[n];
+        node.bucket = bucket;
+        node.prev   = kNil;
+        node.next   = m_heads[bucket];
+        if (node.next != kNil) m_nodes[node.next].prev = n;
+        m_heads[bucket] = n;
+    }
+
+    void unlink(std::uint32_t n) {
+        Node& node = m_nodes[n];
+        if (node.prev != kNil) m_nodes[node.prev].next = node.next;
+        else                   m_heads[node.bucket]    = node.next;
+        if (node.next != kNil) m_nodes[node.next].prev = node.prev;
+
+        if (node.bucket < kOverflow && m_heads[node.bucket] == kNil)
+            m_occupied[node.bucket / kSlots] &= ~(std::uint64_t{1} << (node.bucket % kSlots));
+    }
+
+    /**
+     * Move expired timers of the current lowest-level slot into m_batch.
+     * Before the target tick everything in the slot is due; on the target
+     * tick itself only timers with at <= now are.  Slots are drained in
+     * tick order, so sorting each slot's share keeps m_batch earliest-first.
+     */
+    void drainCurrent(TimePoint now, std::uint64_t target) {
+        const std::size_t first = m_batch.size();
+        std::uint32_t n = m_heads[m_current & (kSlots - 1)];
+        while (n != kNil) {
+            std::uint32_t next = m_nodes[n].next;
+            if (m_current < target || m_nodes[n].at <= now) {
+                m_batch.emplace_back(m_nodes[n].at, m_nodes[n].transition);
+                release(n);
+            }
+            n = next;
+        }
+        if (m_batch.size() - first > 1)
+            std::stable_sort(m_batch.begin() + first, m_batch.end(),
+                [](const auto& a, const auto& b) { return a.first < b.first; });
+    }
+
+    /**
+     * First tick after m_current at which an occupied slot starts (or the
+     * overflow list must be re-examined).  Lower levels always hold earlier
+     * timers than higher ones, so the first level with a candidate wins.
+     */
+    std::uint64_t nextEvent() const noexcept {
+        for (unsigned level = 0; level < kLevels; ++level) {
+            const unsigned shift = kBits * level;
+            const unsigned index = (m_current >> shift) & (kSlots - 1);
+            if (index == kSlots - 1) continue;
+            const std::uint64_t later = m_occupied[level] & (~std::uint64_t{0} << (index + 1));
+            if (later) {
+                const unsigned above = shift + kBits;
+                return ((m_current >> above) << above) |
+                       (static_cast<std::uint64_t>(lowestBit(later)) << shift);
+            }
+        }
+        if (m_heads[kOverflow] != kNil) {
+            const unsigned top = kBits * kLevels;
+            return ((m_current >> top) + 1) << top;
+        }
+        return std::numeric_limits<std::uint64_t>::max();
+    }
+
+    /// Redistribute the higher-level slot (or overflow list) starting at tick @p t.
+    void cascade(std::uint64_t t) {
+        if ((t & ((std::uint64_t{1} << (kBits * kLevels)) - 1)) == 0)
+            replaceBucket(kOverflow);
+        for (unsigned level = kLevels - 1; level >= 1; --level) {
+            const unsigned shift = kBits * level;
+            if ((t & ((std::uint64_t{1} << shift) - 1)) != 0) continue;
+            const unsigned slot = (t >> shift) & (kSlots - 1);
+            replaceBucket(static_cast<std::uint16_t>(level * kSlots + slot));
+        }
+    }
+
+    void replaceBucket(std::uint16_t bucket) {
+        std::uint32_t n = m_heads[bucket];
+        if (n == kNil) return;
+        m_heads[bucket] = kNil;
+        if (bucket < kOverflow)
+            m_occupied[bucket / kSlots] &= ~(std::uint64_t{1} << (bucket % kSlots));
+        while (n != kNil) {
+            std::uint32_t next = m_nodes[n].next;
+            place(n);
+            n = next;
+        }
+    }
+
+    /// Earliest timer: the minimum of the first non-empty slot on the lowest level.
+    std::uint32_t scanEarliest() const {
+        std::uint32_t head = m_heads[kOverflow];
+        for (unsigned level = 0; level < kLevels; ++level) {
+            const unsigned index = (m_current >> (kBits * level)) & (kSlots - 1);
+            const std::uint64_t from = m_occupied[level] & (~std::uint64_t{0} << index);
+            if (from) {
+                head = m_heads[level * kSlots + lowestBit(from)];
+                break;
+            }
+        }
+        std::uint32_t best = head;
+        for (std::uint32_t n = head; n != kNil; n = m_nodes[n].next)
+            if (m_nodes[n].at < m_nodes[best].at) best = n;
+        return best;
+    }
+
+    static unsigned lowestBit(std::uint64_t v) noexcept {
+        return static_cast<unsigned>(__builtin_ctzll(v));
+    }
+
+    TimePoint                                     m_origin;        ///< Tick 0
+    std::uint64_t                                 m_current{0};    ///< Tick the wheel stands at
+    std::vector<Node>                             m_nodes;         ///< Node pool
+    std::uint32_t                                 m_free{kNil};    ///< Free list head
+    std::array<std::uint32_t, kLevels * kSlots + 1> m_heads;       ///< Bucket list heads
+    std::array<std::uint64_t, kLevels>            m_occupied{};    ///< Non-empty slots per level
+    std::size_t                                   m_size{0};       ///< Pending timers
+    mutable std::uint32_t                         m_next{kNil};    ///< Cached front() node
+    mutable bool                                  m_nextValid{false}; ///< m_next is current
+    std::vector<std::pair<TimePoint, std::size_t>> m_batch;        ///< popExpired scratch
+};
@@ -0,0 +1,253 @@
+/**
+ * @file   trace.cpp
+ * @brief  Implements the trace encoding (TraceWriter/TraceReader) and
+ *         replayTrace().
+ *
+ * Layout: the 8-byte magic, the settings
+ *   flags (1 byte: bit 0 run-to-completion) | max microsteps (varint)
+ * (absent in version 1 traces), then records of
+ *   kind (1 byte) | time delta in ns (varint) | fields by kind
+ * where names are a varint id, followed by length and bytes the first
+ * time an id appears, and values are length and bytes.
+ *
+ * @author Martin Ševčík (xsevcim00)
+ * @author Jakub Lůčný (xlucnyj00)
+ * @date   2025-05-06
+ */
+
+#include "trace.hpp"
+#include "automaton.hpp"
+#include "time_source.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace core_fsm {
+
+namespace {
+
+constexpr char kMagic[8] = {'F', 'S', 'M', 'T', 'R', 'C', '2', '\n'};
+constexpr std::size_t kVersionAt = 6;   // Version digit in kMagic
+
+constexpr std::uint8_t kRunToCompletion = 0x01;   // Settings flag bits
+
+/// Kinds carrying a name and a value
+bool hasFields(TraceRecord::Kind k) noexcept {
+    return k == TraceRecord::Kind::Input || k == TraceRecord::Kind::Variable ||
+           k == TraceRecord::Kind::State;
+}
+
+} // namespace
+
+// -- TraceWriter ------------------------------------------------------------
+
+TraceWriter::TraceWriter(const std::string& path, const TraceSettings& settings)
+: m_out(path, std::ios::binary | std::ios::trunc)
+{
+    if (!m_out) throw std::runtime_error("cannot create trace '" + path + "'");
+    m_out.write(kMagic, sizeof(kMagic));
+    m_out.put(static_cast<char>(settings.runToCompletion ? kRunToCompletion : 0));
+    putVarint(settings.maxMicrosteps);
+}
+
+void TraceWriter::putVarint(std::uint64_t v) {
+    char buf[10];
+    std::size_t n = 0;
+    do {
+        std::uint8_t byte = v & 0x7f;
+        v >>= 7;
+        if (v) byte |= 0x80;
+        buf[n++] = static_cast<char>(byte);
+    } while (v);
+    m_out.write(buf, static_cast<std::streamsize>(n));
+}
+
+void TraceWriter::putString(const std::string& s) {
+    putVarint(s.size());
+    m_out.write(s.data(), static_cast<std::streamsize>(s.size()));
+}
+
+void TraceWriter::write(TraceRecord::Kind kind, TimePoint at,
+                        const std::string& name, const std::string& value)
+{
+    if (kind == TraceRecord::Kind::Start) {
+        m_origin = at;
+        m_last   = std::chrono::nanoseconds(0);
+    }
+    // Times never go back within a trace; clamp in case of a stray record
+    const auto rel   = std::max(std::chrono::nanoseconds(at - m_origin), m_last);
+    const auto delta = rel - m_last;
+    m_last = rel;
+
+    m_out.put(static_cast<char>(kind));
+    putVarint(static_cast<std::uint64_t>(delta.count()));
+    if (hasFields(kind)) {
+        // Names (and State triggers) repeat: intern them
+        auto putName = [this](const std::string& n) {
+            auto [it, added] = m_names.try_emplace(n, static_cast<std::uint32_t>(m_names.size()));
+            putVarint(it->second);
+            if (added) putString(n);
+        };
+        putName(name);
+        if (kind == TraceRecord::Kind::State) putName(value);
+        else                                  putString(value);
+    }
+    ++m_records;
+}
+
+// -- TraceReader ------------------------------------------------------------
+
+TraceReader::TraceReader(const std::string& path)
+: m_in(path, std::ios::binary)
+{
+    // Version 1 differs in the version digit only and has no settings
+    char magic[sizeof(kMagic)];
+    if (!m_in || !m_in.read(magic, sizeof(magic)) ||
+        !std::equal(magic, magic + kVersionAt, kMagic) ||
+        (magic[kVersionAt] != '1' && magic[kVersionAt] != kMagic[kVersionAt]) ||
+        magic[kVersionAt + 1] != kMagic[kVersionAt + 1])
+        throw std::runtime_error("'" + path + "' is not an FSM trace");
+    if (magic[kVersionAt] == '1') return;
+
+    const int flags = m_in.get();
+    std::uint64_t maxMicrosteps;
+    if (flags == EOF || !getVarint(maxMicrosteps))
+        throw std::runtime_error("truncated trace header");
+    m_settings = TraceSettings{(flags & kRunToCompletion) != 0,
+                               static_cast<std::uint32_t>(maxMicrosteps)};
+}
+
+bool TraceReader::getVarint(std::uint64_t& v) {
+    v = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        const int c = m_in.get();
+        if (c == EOF) return false;
+        v |= static_cast<std::uint64_t>(c & 0x7f) << shift;
+        if (!(c & 0x80)) return true;
+    }
+    return false;
+}
+
+std::string TraceReader::getString() {
+    std::uint64_t len;
+    if (!getVarint(len)) throw std::runtime_error("truncated trace");
+    std::string s(len, '\0');
+    if (!m_in.read(s.data(), static_cast<std::streamsize>(len)))
+        throw std::runtime_error("truncated trace");
+    return s;
+}
+
+bool TraceReader::next(TraceRecord& rec) {
+    const int kind = m_in.get();
+    if (kind == EOF) return false;
+    if (kind > static_cast<int>(TraceRecord::Kind::State))
+        throw std::runtime_error("corrupt trace record");
+
+    std::uint64_t delta;
+    if (!getVarint(delta)) throw std::runtime_error("truncated trace");
+    rec.kind = static_cast<TraceRecord::Kind>(kind);
+    if (rec.kind == TraceRecord::Kind::Start) m_last = std::chrono::nanoseconds(0);
+    m_last += std::chrono::nanoseconds(delta);
+    rec.at = m_last;
+    rec.name.clear();
+    rec.value.clear();
+
+    if (hasFields(rec.kind)) {
+        auto getName = [this]() -> const std::string& {
+            std::uint64_t id;
+            if (!getVarint(id)) throw std::runtime_error("truncated trace");
+            if (id == m_names.size()) m_names.push_back(getString());
+            if (id >= m_names.size()) throw std::runtime_error("corrupt trace name");
+            return m_names[id];
+        };
+        rec.name = getName();
+        rec.value = (rec.kind == TraceRecord::Kind::State) ? getName() : getString();
+    }
+    return true;
+}
+
+// -- Replay -----------------------------------------------------------------
+
+/**
+ * Steps the automaton once per distinct recorded time, with the inputs of
+ * that time queued, so timers fire and inputs drain exactly as they did
+ * while recording.
+ */
+ReplayReport replayTrace(Automaton& fsm, TraceReader& trace)
+{
+    using Clock = std::chrono::steady_clock;
+    ReplayReport report;
+
+    // Replay under the recorded settings; older traces rely on the caller
+    if (const auto& s = trace.settings())
+        fsm.setRunToCompletion(s->runToCompletion, s->maxMicrosteps);
+
+    VirtualTime clock{TimeSource::TimePoint{}};   // Trace time 0
+    fsm.setTimeSource(clock);
+    // A burst longer than the input queue: drain it here, nobody else will
+    fsm.setFullHandler([&fsm, &clock] { fsm.step(clock.now()); });
+
+    struct Expected {
+        std::string              state;
+        std::string              trigger;
+        std::chrono::nanoseconds at;
+    };
+    std::vector<Expected> expected;
+
+    const auto wallStart = Clock::now();
+    bool started = false;
+    bool due     = false;   // Records at clock.now() not stepped yet
+    TraceRecord rec;
+    while (trace.next(rec)) {
+        const TimeSource::TimePoint at{std::chrono::duration_cast<Clock::duration>(rec.at)};
+        switch (rec.kind) {
+        case TraceRecord::Kind::Start:
+            if (started) break;
+            fsm.start();
+            fsm.step(clock.now());
+            started = true;
+            break;
+        case TraceRecord::Kind::State:
+            expected.push_back(Expected{rec.name, rec.value, rec.at});
+            break;
+        default:
+            if (due && at != clock.now()) fsm.step(clock.now());
+            clock.advanceTo(at);
+            due = true;
+            if (rec.kind == TraceRecord::Kind::Input) {
+                fsm.injectInput(rec.name, rec.value);
+                ++report.inputs;
+            }
+            else if (rec.kind == TraceRecord::Kind::Variable) {
+                const Automaton::Injection set{Automaton::Injection::Kind::Variable, rec.name, rec.value};
+                fsm.injectBatch(&set, 1);
+                ++report.inputs;
+            }
+            break;
+        }
+    }
+    if (due) fsm.step(clock.now());
+    report.wall = Clock::now() - wallStart;
+
+    fsm.setFullHandler({});
+    fsm.setTimeSource(TimeSource::steady());
+
+    // Compare the produced log with the recorded one
+    const auto& log = fsm.log();
+    report.expected    = expected.size();
+    report.transitions = log.size();
+    report.matches     = log.size() == expected.size();
+    report.mismatch    = std::min(log.size(), expected.size());
+    for (std::size_t i = 0; i < std::min(log.size(), expected.size()); ++i) {
+        if (log[i].state != expected[i].state || log[i].triggerInput != expected[i].trigger) {
+            report.matches  = false;
+            report.mismatch = i;
+            break;
+        }
+        const auto skew = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            log[i].timestamp.time_since_epoch()) - expected[i].at;
+        report.maxSkew = std::max(report.maxSkew, skew < skew.zero() ? -skew : skew);
+    }
+    return report;
+}
+
+} // namespace core_fsm
@@ -0,0 +1,159 @@
+/**
+ * @file   trace.hpp
+ * @brief  Compact binary traces of what an automaton consumed, and their
+ *         deterministic replay in virtual time.
+ *
+ * A trace holds, in order, every input and variable update the automaton
+ * took from its queue, every step in which timers fired, and every state
+ * it entered (the expected EventLog).  Records carry the time since
+ * start() as a varint nanosecond delta; names are interned on first use.
+ * The header stores the automaton settings the replay must match.
+ *
+ * @author Martin Ševčík (xsevcim00)
+ * @author Jakub Lůčný (xlucnyj00)
+ * @date   2025-05-06
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace core_fsm {
+
+class Automaton;
+
+/// One entry of a trace.
+struct TraceRecord {
+    enum class Kind : std::uint8_t {
+        Start,     ///< start(): time origin of the trace
+        Tick,      ///< A step in which timers fired
+        Input,     ///< Input consumed (name, value)
+        Variable,  ///< Variable update consumed (name, value)
+        State      ///< State entered (name, trigger input)
+    };
+
+    Kind                     kind{Kind::Start};
+    std::chrono::nanoseconds at{0};   ///< Time since Start
+    std::string              name;
+    std::string              value;
+};
+
+/// Automaton settings that change the transitions a trace replays to.
+struct TraceSettings {
+    bool          runToCompletion{false}; ///< See Automaton::setRunToCompletion()
+    std::uint32_t maxMicrosteps{64};      ///< Livelock guard per step
+};
+
+/**
+ * @class TraceWriter
+ * @brief Appends records to a trace file (one writer thread).
+ */
+class TraceWriter {
+public:
+    using TimePoint = std::chrono::steady_clock::time_point;
+
+    /**
+     * @brief Create (truncate) the trace file and write its header.
+     * @param path      Trace file.
+     * @param settings  Settings of the recorded automaton.
+     * @throws std::runtime_error if the file cannot be opened.
+     */
+    TraceWriter(const std::string& path, const TraceSettings& settings);
+
+    /**
+     * @brief Append one record.
+     * @param kind   Record kind; Start sets the time origin.
+     * @param at     Time of the event (the automaton's time source).
+     * @param name   Input, variable or state name (empty for Start/Tick).
+     * @param value  Value, or the trigger input of a State record.
+     */
+    void write(TraceRecord::Kind kind, TimePoint at,
+               const std::string& name = {}, const std::string& value = {});
+
+    /** @brief Push buffered records to the file. */
+    void flush() { m_out.flush(); }
+
+    /** @return Records written so far. */
+    std::size_t records() const noexcept { return m_records; }
+
+private:
+    void putVarint(std::uint64_t v);
+    void putString(const std::string& s);
+
+    std::ofstream                                m_out;
+    TimePoint                                    m_origin{};
+    std::chrono::nanoseconds                     m_last{0};   // Time of the previous record
+    std::unordered_map<std::string, std::uint32_t> m_names;   // Interned names
+    std::size_t                                  m_records{0};
+};
+
+/**
+ * @class TraceReader
+ * @brief Reads a trace written by TraceWriter.
+ */
+class TraceReader {
+public:
+    /**
+     * @brief Open a trace and check its header.
+     * @throws std::runtime_error if the file is missing or not a trace.
+     */
+    explicit TraceReader(const std::string& path);
+
+    /**
+     * @brief Settings the trace was recorded with.
+     * @return std::nullopt for traces of the first format, which did not
+     *         store them.
+     */
+    const std::optional<TraceSettings>& settings() const noexcept { return m_settings; }
+
+    /**
+     * @brief Read the next record.
+     * @return False at the end of the trace.
+     * @throws std::runtime_error on a truncated or corrupt record.
+     */
+    bool next(TraceRecord& rec);
+
+private:
+    bool        getVarint(std::uint64_t& v);
+    std::string getString();
+
+    std::ifstream            m_in;
+    std::optional<TraceSettings> m_settings;   // From the header
+    std::chrono::nanoseconds m_last{0};
+    std::vector<std::string> m_names;   // Interned names by id
+};
+
+/// Outcome of replayTrace().
+struct ReplayReport {
+    std::size_t              inputs{0};        ///< Inputs and variable updates fed
+    std::size_t              expected{0};      ///< State entries in the trace
+    std::size_t              transitions{0};   ///< State entries produced by the replay
+    std::size_t              mismatch{0};      ///< Index of the first differing entry (if !matches)
+    bool                     matches{false};   ///< Same states and triggers, in order
+    std::chrono::nanoseconds maxSkew{0};       ///< Largest timestamp difference of matching entries
+    std::chrono::nanoseconds wall{0};          ///< Time the replay took
+};
+
+/**
+ * @brief Feed a trace through a freshly built automaton as fast as possible.
+ *
+ * The automaton is switched to a VirtualTime that follows the trace's
+ * timestamps, started, and stepped at every recorded time; its EventLog
+ * is then compared with the trace's State records.  The settings stored
+ * in the trace (TraceReader::settings()) are applied first.
+ *
+ * @param fsm    Built but not yet started automaton (configured like the
+ *               recorded one if the trace does not store its settings).
+ * @param trace  Trace to replay from its beginning.
+ * @return       Counts, verdict and timing.
+ */
+ReplayReport replayTrace(Automaton& fsm, TraceReader& trace);
+
+} // namespace core_fsm
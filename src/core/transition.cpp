@@ -13,54 +13,6 @@
 
 namespace core_fsm {
 
-    namespace {
-    // -- JS Engine Singleton ------------------------------------------------
-    
-    /**
-     * Returns a singleton QJSEngine instance with predefined helper functions.
-     * Sets up JS utility functions that are available in all guard expressions:
-     * - valueof(name): Gets value from inputs or vars (inputs take precedence)
-     * - defined(name): Checks if name exists in inputs or vars
-     * - atoi(s): Converts string to integer (parseInt wrapper)
-     */
-    QJSEngine& engine() {
-        static bool initialized = false;
-        static QJSEngine e;
-        if (!initialized) {
-            /*  Helper functions that will be visible from every guard.
-                -------------------------------------------------------
-                • valueof(name)  – returns **last known value** of an input
-                                  OR of a variable (inputs shadow variables).
-                • defined(name)  – true when the symbol is present either in
-                                  inputs **or** variables.
-                • atoi(s)        – convenience wrapper around parseInt.
-            */
-            e.evaluate(R"(
-                function valueof(name)
-                {
-                    if (Object.prototype.hasOwnProperty.call(ctx.inputs, name))
-                        return String(ctx.inputs[name]);   // any JS primitive → str
-
-                    if (Object.prototype.hasOwnProperty.call(ctx.vars, name))
-                        return String(ctx.vars[name]);
-
-                    return "";                             // unknown → empty str
-                }
-
-                function defined(name)
-                {
-                    return Object.prototype.hasOwnProperty.call(ctx.inputs, name) ||
-                           Object.prototype.hasOwnProperty.call(ctx.vars,   name);
-                }
-
-                function atoi(s) { return parseInt(s, 10); }
-            )");
-            initialized = true;
-        }
-        return e;
-    }
-}
-
 // -- Transition implementations -------------------------------------------
 
 /**
@@ -77,17 +29,7 @@ Transition::Transition(std::string inputName,
   , m_src(src)
   , m_dst(dst)
 {
-    if (!guardExpr.empty()) {
-        // Wrap the expression in a JS function () => <expr>
-        QString jsFn = QString("(function(){ return %1; })").arg(
-            QString::fromStdString(guardExpr)
-        );
-        QJSValue fn = engine().evaluate(jsFn);
-        if (!fn.isCallable()) {
-            throw std::runtime_error("Guard compile error: " + guardExpr);
-        }
-        guardFn_ = fn;
-    }
+    compileGuard(guardExpr);
 }
 
 /**
@@ -100,18 +42,52 @@ Transition::Transition(std::string inputName,
                        std::size_t src,
                        std::size_t dst)
   : m_inputName(std::move(inputName))
-  , m_delayVarName(std::move(delayVarName))
   , m_src(src)
   , m_dst(dst)
+  , m_delayVarName(std::move(delayVarName))
 {
-    if (!guardExpr.empty()) {
-        QString jsFn = QString("(function(){ return %1; })")
-                        .arg(QString::fromStdString(guardExpr));
-        QJSValue fn = engine().evaluate(jsFn);
-        if (!fn.isCallable())
-            throw std::runtime_error("Guard compile error: " + guardExpr);
-        guardFn_ = fn;
-    }
+    compileGuard(guardExpr);
+}
+
+/**
+ * Compiles the guard with the native compiler when it stays within the
+ * supported subset; otherwise wraps it in a JS function () => <expr>.
+ */
+void Transition::compileGuard(const std::string& guardExpr)
+{
+    m_guardExpr = guardExpr;
+    if (guardExpr.empty()) return;
+
+    m_nativeGuard = native::Program::compileGuard(guardExpr, &m_fallbackReason);
+    if (m_nativeGuard) return;
+
+    QString jsFn = QString("(function(){ return %1; })")
+                    .arg(QString::fromStdString(guardExpr));
+    const script::FunctionId id = script::registerFunction(script::Dialect::Guard, jsFn);
+    // Compiling here also warms this thread's cache
+    if (!script::function(id).isCallable())
+        throw std::runtime_error("Guard compile error: " + guardExpr);
+    m_scriptGuard = id;
+}
+
+/**
+ * Reports whether the guard runs natively, through the JS engine, or
+ * whether there is no guard at all.
+ */
+Transition::GuardPath Transition::guardPath() const noexcept
+{
+    if (m_nativeGuard)          return GuardPath::Native;
+    if (m_scriptGuard != script::kNoFunction) return GuardPath::Script;
+    return GuardPath::None;
+}
+
+/**
+ * Resolves the names referenced by a native guard to slot ids so that
+ * evaluation no longer hashes strings.  JS guards are left untouched.
+ */
+void Transition::bindSlots(IOSlots& inputs, const VarSlots& vars)
+{
+    if (m_nativeGuard) m_nativeGuard->bind(inputs, vars);
 }
 
 /**
@@ -124,46 +100,36 @@ bool Transition::isTriggered(const std::string& incomingInput,
 {
     // Input must match (empty==unconditional)
     if (incomingInput != m_inputName) return false;
+    return guardHolds(ctx);
+}
 
-    // No guard => always true
-    if (!guardFn_.isCallable()) return true;
-
-    // Build a JS context object { inputs: {...}, vars: {...} }
-    QJSEngine& eng = engine();
-    QJSValue jsCtx = eng.newObject();
-
-    // Populate ctx.inputs with string values
-    QJSValue jsInputs = eng.newObject();
-    for (auto const& kv : ctx.inputs) {
-        jsInputs.setProperty(
-            QString::fromStdString(kv.first),
-            QString::fromStdString(kv.second)
-        );
-    }
-    jsCtx.setProperty("inputs", jsInputs);
+/**
+ * Evaluates the guard expression against the given context.
+ * Used directly by the automaton's dispatch index, which has already
+ * matched the trigger by id.
+ */
+bool Transition::guardHolds(const GuardCtx& ctx) const
+{
+    // Native subset: evaluate straight against the slots
+    if (m_nativeGuard) return m_nativeGuard->test(ctx.vars, ctx.inputs);
 
-    // Populate ctx.vars with type-appropriate values
-    QJSValue jsVars = eng.newObject();
-    for (auto const& kv : ctx.vars) {
-        QJSValue v;
-        std::visit([&](auto&& x) {
-            using T = std::decay_t<decltype(x)>;
-            if constexpr (std::is_same_v<T, int>)
-                v = QJSValue(x);
-            else if constexpr (std::is_same_v<T, double>)
-                v = QJSValue(x);
-            else if constexpr (std::is_same_v<T, std::string>)
-                v = QJSValue(QString::fromStdString(x));
-        }, kv.second);
-        jsVars.setProperty(QString::fromStdString(kv.first), v);
+    // No guard => always true
+    if (m_scriptGuard == script::kNoFunction) return true;
+
+    // Bring the automaton's persistent JS mirror up to date; only slots
+    // written since the previous guard are pushed
+    static thread_local script::JsContext scratch{script::Dialect::Guard};
+    script::JsContext* js = ctx.script;
+    if (!js) {
+        js = &scratch;
+        js->reset();
     }
-    jsCtx.setProperty("vars", jsVars);
-
-    // Make context accessible to helper functions
-    eng.globalObject().setProperty("ctx", jsCtx);
+    js->syncInputs(ctx.inputs);
+    js->syncVars(ctx.vars);
+    js->install();
 
     // Evaluate guard function and handle errors
-    QJSValue fn = guardFn_;
+    QJSValue fn = script::function(m_scriptGuard);
     QJSValue result = fn.call();
     if (result.isError()) {
         throw std::runtime_error(
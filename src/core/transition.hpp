@@ -12,21 +12,30 @@
 #include <string>
 #include <chrono>
 #include <cstddef>
-#include <unordered_map>
+#include <optional>
 #include <QJSEngine>
 #include <QJSValue>
 #include <QString>
 #include "variable.hpp"
+#include "slots.hpp"
+#include "native_script.hpp"
+#include "script_engine.hpp"
 
 namespace core_fsm {
 
 /**
  * @struct GuardCtx
- * @brief Provides current variables and inputs for guard evaluation.
+ * @brief Read-only view of the live variables and inputs for guard evaluation.
+ *
+ * Guards never mutate state, so no copy is taken; the view is valid for as
+ * long as the automaton does not change the underlying slots.  JS guards
+ * read the slots through @c script, a persistent mirror kept in sync
+ * incrementally.
  */
 struct GuardCtx {
-    const std::unordered_map<std::string, Value>&     vars;    ///< Current variable values
-    const std::unordered_map<std::string, std::string>& inputs; ///< Last-seen input values
+    const VarSlots&    vars;            ///< Current variable values
+    const IOSlots&     inputs;          ///< Last-seen input values
+    script::JsContext* script{nullptr}; ///< JS mirror of the slots (null = rebuild)
 };
 
 /**
@@ -36,9 +45,15 @@ struct GuardCtx {
  * A Transition may fire when a specified input arrives (or unconditionally),
  * and an optional JavaScript guard evaluates to true.  Supports both fixed
  * numeric delays and dynamic delays based on a variable’s value.
+ *
+ * Guards within the native subset (see native_script.hpp) are evaluated
+ * without the JS engine; all others are compiled into a QJSEngine function.
  */
 class Transition {
 public:
+    /** @brief How the guard of a transition is evaluated. */
+    enum class GuardPath { None, Native, Script };
+
     /**
      * @brief Construct a transition with a fixed delay.
      * @param inputName   Name of input event (empty = unconditional).
@@ -76,6 +91,32 @@ public:
     bool isTriggered(const std::string& incomingInput,
                      const GuardCtx&    ctx) const;
 
+    /**
+     * @brief Evaluate only the guard, assuming the trigger already matched.
+     * @param ctx  GuardCtx providing current vars & inputs.
+     * @return True if there is no guard or the JS guard returns true.
+     */
+    bool guardHolds(const GuardCtx& ctx) const;
+
+    /** @brief Name of the triggering input (empty = unconditional). */
+    const std::string& inputName() const noexcept { return m_inputName; }
+
+    /** @brief Guard source text (empty = no guard). */
+    const std::string& guardExpr() const noexcept { return m_guardExpr; }
+
+    /** @brief Which evaluator handles the guard. */
+    GuardPath guardPath() const noexcept;
+
+    /** @brief Why the guard fell back to the JS engine (empty otherwise). */
+    const std::string& fallbackReason() const noexcept { return m_fallbackReason; }
+
+    /**
+     * @brief Resolve names used by a native guard to the automaton's slots.
+     * @param inputs  Input slots (referenced inputs are declared).
+     * @param vars    Variable slots.
+     */
+    void bindSlots(IOSlots& inputs, const VarSlots& vars);
+
     /** @brief True if there is a fixed (numeric) delay. */
     bool isDelayed() const noexcept { return m_delay.count() > 0; }
 
@@ -95,12 +136,18 @@ public:
     const std::string& variableDelayName() const noexcept { return m_delayVarName; }
 
 private:
+    /// Compile @p guardExpr natively, or register it as m_scriptGuard if outside the subset.
+    void compileGuard(const std::string& guardExpr);
+
     std::string              m_inputName;     ///< Trigger input name
     std::chrono::milliseconds m_delay{0};      ///< Fixed delay in ms
     std::size_t              m_src;           ///< Source state index
     std::size_t              m_dst;           ///< Destination state index
     std::string              m_delayVarName; ///< Variable name for dynamic delay
-    QJSValue                 guardFn_;       ///< Compiled JS guard function
+    std::string              m_guardExpr;    ///< Guard source text
+    std::optional<native::Program> m_nativeGuard; ///< Natively compiled guard
+    std::string              m_fallbackReason; ///< Why the native compiler declined
+    script::FunctionId       m_scriptGuard{script::kNoFunction}; ///< JS guard (compiled per thread)
 };
 
 } // namespace core_fsm
@@ -0,0 +1,189 @@
+/**
+ * @file   work_stealing_pool.hpp
+ * @brief  Fixed-size thread pool with per-worker job deques and stealing.
+ *
+ * Jobs are plain indices handed to one run callback, so submitting never
+ * allocates.  A worker pops its own deque LIFO (cache-warm work first) and
+ * steals FIFO from the others when it runs dry; idle workers sleep.
+ *
+ * @author Martin Ševčík (xsevcim00)
+ * @author Jakub Lůčný (xlucnyj00)
+ * @date   2025-05-06
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace core_fsm {
+
+/**
+ * @class WorkStealingPool
+ * @brief Runs submitted job ids on a fixed set of worker threads.
+ *
+ * Each worker owns a deque guarded by its own mutex, so the owner and a
+ * thief only contend when they touch the same deque.  Jobs submitted from
+ * a worker go to that worker's deque; external submissions are spread
+ * round-robin.  A job submitted while it is still queued runs twice, so
+ * callers that need at-most-once scheduling keep their own flag.
+ */
+class WorkStealingPool {
+public:
+    /// Job callback: (job id, index of the worker running it)
+    using RunFn = std::function<void(std::size_t job, std::size_t worker)>;
+
+    /**
+     * @brief Start the workers.
+     * @param workers  Number of threads (at least one).
+     * @param run      Called for every job.
+     */
+    WorkStealingPool(std::size_t workers, RunFn run)
+        : m_run(std::move(run))
+    {
+        if (workers == 0) workers = 1;
+        m_queues.reserve(workers);
+        for (std::size_t i = 0; i < workers; ++i)
+            m_queues.push_back(std::make_unique<Queue>());
+        m_threads.reserve(workers);
+        for (std::size_t i = 0; i < workers; ++i)
+            m_threads.emplace_back([this, i] { workerLoop(i); });
+    }
+
+    ~WorkStealingPool() { stop(); }
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    /** @return Number of worker threads. */
+    std::size_t workers() const noexcept { return m_queues.size(); }
+
+    /**
+     * @brief Queue a job (any thread).
+     * @param job  Id passed to the run callback.
+     */
+    void submit(std::size_t job) {
+        if (m_stop.load(std::memory_order_acquire)) return;
+
+        std::size_t target = t_worker.pool == this
+            ? t_worker.index
+            : m_next.fetch_add(1, std::memory_order_relaxed) % m_queues.size();
+        // Count first so a worker never sees a job it cannot account for
+        m_pending.fetch_add(1, std::memory_order_seq_cst);
+        {
+            Queue& q = *m_queues[target];
+            std::lock_guard<std::mutex> lk(q.mtx);
+            q.jobs.push_back(job);
+        }
+
+        // Pairs with the sleeper count update in sleep(): either the sleeper
+        // sees the new job or we see the sleeper
+        if (m_sleepers.load(std::memory_order_seq_cst) > 0) {
+            std::lock_guard<std::mutex> lk(m_sleepMtx);
+            m_sleepCv.notify_one();
+        }
+    }
+
+    /**
+     * @brief Stop and join the workers; queued jobs are dropped.
+     */
+    void stop() {
+        if (m_stop.exchange(true)) return;
+        {
+            std::lock_guard<std::mutex> lk(m_sleepMtx);
+            m_sleepCv.notify_all();
+        }
+        for (auto& t : m_threads)
+            if (t.joinable()) t.join();
+    }
+
+private:
+    /// One worker's deque, on its own cache line.
+    struct alignas(64) Queue {
+        std::mutex              mtx;
+        std::deque<std::size_t> jobs;
+    };
+
+    /// Identifies the pool and worker a thread belongs to.
+    struct WorkerId {
+        const WorkStealingPool* pool;
+        std::size_t             index;
+    };
+
+    /// Zero-initialized: threads outside any pool have pool == nullptr
+    static inline thread_local WorkerId t_worker;
+
+    /// Pop from the own deque's back, else steal from another's front.
+    bool take(std::size_t self, std::size_t& job) {
+        {
+            Queue& q = *m_queues[self];
+            std::lock_guard<std::mutex> lk(q.mtx);
+            if (!q.jobs.empty()) {
+                job = q.jobs.back();
+                q.jobs.pop_back();
+                return true;
+            }
+        }
+        const std::size_t n = m_queues.size();
+        for (std::size_t k = 1; k < n; ++k) {
+            Queue& q = *m_queues[(self + k) % n];
+            std::unique_lock<std::mutex> lk(q.mtx, std::try_to_lock);
+            if (!lk.owns_lock() || q.jobs.empty()) continue;
+            job = q.jobs.front();
+            q.jobs.pop_front();
+            return true;
+        }
+        return false;
+    }
+
+    /// Block until a job may be available or the pool stops.
+    void sleep() {
+        std::unique_lock<std::mutex> lk(m_sleepMtx);
+        m_sleepers.fetch_add(1, std::memory_order_seq_cst);
+        m_sleepCv.wait(lk, [&] {
+            return m_stop.load(std::memory_order_acquire) ||
+                   m_pending.load(std::memory_order_seq_cst) > 0;
+        });
+        m_sleepers.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    void workerLoop(std::size_t self) {
+        t_worker = WorkerId{this, self};
+        while (!m_stop.load(std::memory_order_acquire)) {
+            std::size_t job;
+            if (take(self, job)) {
+                m_pending.fetch_sub(1, std::memory_order_relaxed);
+                m_run(job, self);
+                continue;
+            }
+            // A skipped (contended) deque may still hold work: only sleep
+            // once nothing is pending at all
+            if (m_pending.load(std::memory_order_seq_cst) > 0) {
+                std::this_thread::yield();
+                continue;
+            }
+            sleep();
+        }
+        t_worker = WorkerId{nullptr, 0};
+    }
+
+    RunFn                               m_run;         ///< Job callback
+    std::vector<std::unique_ptr<Queue>> m_queues;      ///< One deque per worker
+    std::vector<std::thread>            m_threads;     ///< Workers
+    std::atomic<std::size_t>            m_next{0};     ///< Round-robin target for external submits
+    std::atomic<std::size_t>            m_pending{0};  ///< Queued, not yet taken jobs
+    std::atomic<std::size_t>            m_sleepers{0}; ///< Workers inside sleep()
+    std::atomic<bool>                   m_stop{false}; ///< Set by stop()
+    std::mutex                          m_sleepMtx;    ///< Guards the sleep condition
+    std::condition_variable             m_sleepCv;     ///< Wakes sleeping workers
+};
+
+} // namespace core_fsm
@@ -8,28 +8,41 @@
  * @date   2025-05-06
  */
 #include <chrono>
+#include <cerrno>
+#include <cstdlib>
 #include <csignal>
 #include <fstream>
 #include <iostream>
+#include <memory>
+#include <optional>
 #include <regex>
 #include <string>
 #include <thread>
 #include <unordered_map>
+#include <vector>
+#include <algorithm>
 #include <atomic>
 #include <QCoreApplication>
 #include <unistd.h>
-#include <sys/select.h>
 
 #include <nlohmann/json.hpp>
 #include <script_engine.hpp>
+#include <native_script.hpp>
 
 #include "../core/automaton.hpp"
+#include "../core/automaton_host.hpp"
 #include "../core/context.hpp"
+#include "../core/log.hpp"
 #include "../core/persistence.hpp"
+#include "../core/reactor.hpp"
 #include "../core/state.hpp"
+#include "../core/trace.hpp"
 #include "../core/transition.hpp"
 #include "../core/variable.hpp"
+#include "../core/io/event_loop.hpp"
+#include "../core/io/snapshot_sender.hpp"
 #include "../core/io/udp_channel.hpp"
+#include "../core/io/wire_format.hpp"
 
 using namespace std::chrono_literals;
 using core_fsm::Automaton;
@@ -59,10 +72,21 @@ static core_fsm::Variable::Type mapVarType(const std::string& t) {
  * 
  * @param doc The parsed FSM document containing the state machine definition
  * @param fsm The Automaton instance to configure
+ * @param verbose Report which evaluator every action and guard ended up on
+ * @return Number of actions and guards that need the JS engine
  */
-static void buildFromDocument(const core_fsm::persistence::FsmDocument& doc, 
-                              core_fsm::Automaton& fsm)
+static std::size_t buildFromDocument(const core_fsm::persistence::FsmDocument& doc, 
+                                     core_fsm::Automaton& fsm,
+                                     bool verbose = true)
 {
+    std::size_t scriptActions = 0;
+
+    // 0) Ports ----------------------------------------------------------------
+    // Resolve declared input/output names to slots before anything runs
+    for (const auto& in : doc.inputs)
+        fsm.addInput(in);
+    for (const auto& out : doc.outputs)
+        fsm.addOutput(out);
 
     // 1) Variables ------------------------------------------------------------
     for (const auto& v : doc.variables) {
@@ -94,25 +118,34 @@ static void buildFromDocument(const core_fsm::persistence::FsmDocument& doc,
     for (const auto& st : doc.states) {
         const std::string src = st.onEnter;
         const std::string stateId = st.id; // Store the ID locally
+
+        // Simple actions run on the native interpreter, no JS round trip
+        std::string why;
+        if (auto prog = core_fsm::native::Program::compileAction(src, fsm.vars(), &why)) {
+            if (verbose)
+                std::cerr << "[fsm_runtime] action " << stateId << " [native]\n";
+            fsm.addState(core_fsm::State{stateId, std::move(*prog)}, st.initial);
+            continue;
+        }
+        ++scriptActions;
+        if (verbose)
+            std::cerr << "[fsm_runtime] action " << stateId << " [js: " << why << "]\n";
+
+        // Wrap in a function to allow multiple statements; compiled once
+        // per thread that runs it (see core_fsm::script::function())
+        const core_fsm::script::FunctionId fnId = core_fsm::script::registerFunction(
+            core_fsm::script::Dialect::Action,
+            "(function(){ " + QString::fromStdString(src) + "; })");
+
         fsm.addState(core_fsm::State{
             stateId,
-            [src, stateId](core_fsm::Context& ctx){
+            [fnId](core_fsm::Context& ctx){
                 // 1) bind C++ context into JS
                 auto& eng = engine();
                 bindCtx(eng, ctx);
 
-                // 2) compile & cache the JS action
-                static QHash<QString,QJSValue> cache;
-                QString key = QString::fromStdString(src);
-                QJSValue fn = cache.value(key);
-                if (!fn.isCallable()) {
-                    // wrap in function to allow multiple statements
-                    QString wrap = "(function(){ " + key + "; })";
-                    fn = eng.evaluate(wrap);
-                    cache.insert(key, fn);
-                }
-
-                // 3) execute and pull back changes
+                // 2) execute and pull back changes
+                QJSValue fn = core_fsm::script::function(fnId);
                 if (fn.isCallable()) fn.call();
                 pullBack(eng, ctx);
             }
@@ -135,68 +168,468 @@ static void buildFromDocument(const core_fsm::persistence::FsmDocument& doc,
             varInit[v.name] = static_cast<int>(v.init.get<double>());
     }
 
+    std::size_t nativeGuards = 0, scriptGuards = 0;
     for (const auto& tr : doc.transitions) {
-        if (tr.delay_ms.is_string()) {
-            // variable‐delay transition
-            fsm.addTransition(core_fsm::Transition(
-                tr.trigger,
-                tr.guard,
-                tr.delay_ms.get<std::string>(),   // just the var name
-                idx.at(tr.from),
-                idx.at(tr.to)
-            ));
-        }
-        else {
+        auto t = [&]{
+            if (tr.delay_ms.is_string()) {
+                // variable‐delay transition
+                return core_fsm::Transition(
+                    tr.trigger,
+                    tr.guard,
+                    tr.delay_ms.get<std::string>(),   // just the var name
+                    idx.at(tr.from),
+                    idx.at(tr.to)
+                );
+            }
             // fixed numeric (or zero) delay
             std::chrono::milliseconds delay{0};
             if (tr.delay_ms.is_number_integer())
                 delay = std::chrono::milliseconds(tr.delay_ms.get<int>());
-    
-            fsm.addTransition(core_fsm::Transition(
+
+            return core_fsm::Transition(
                 tr.trigger,
                 tr.guard,
                 delay,                           // fixed ms
                 idx.at(tr.from),
                 idx.at(tr.to)
-            ));
+            );
+        }();
+
+        // Report which evaluator each guard ended up on
+        using Path = core_fsm::Transition::GuardPath;
+        if (t.guardPath() == Path::Native) {
+            ++nativeGuards;
+            if (verbose) std::cerr << "[fsm_runtime] guard " << tr.from << " -> " << tr.to
+                      << " [native]: " << tr.guard << "\n";
+        }
+        else if (t.guardPath() == Path::Script) {
+            ++scriptGuards;
+            if (verbose) std::cerr << "[fsm_runtime] guard " << tr.from << " -> " << tr.to
+                      << " [js: " << t.fallbackReason() << "]: " << tr.guard << "\n";
         }
+        fsm.addTransition(t);
     }
+    if (verbose)
+        std::cerr << "[fsm_runtime] guards: " << nativeGuards << " native, "
+                  << scriptGuards << " js\n";
+
+    // 4) Dispatch index -------------------------------------------------------
+    fsm.buildDispatchIndex();
+    return scriptActions + scriptGuards;
 }
 
 /**
- * Checks if stdin has data available to read without blocking.
- * Uses select() with zero timeout to perform a non-blocking poll.
- * 
- * @return true if data is available on stdin, false otherwise
+ * Applies one control message (inject, setVar or batch) to an automaton.
+ *
+ * Each message is one UDP datagram, so a "batch" is bounded by
+ * io_bridge::MAX_DATAGRAM (65507 bytes) of JSON; a sender with more
+ * entries splits them over several batches.
+ *
+ * @param j     Parsed message
+ * @param fsm   Target automaton
+ * @param batch Scratch buffer for "batch" messages, reused between calls
+ * @return false if the message type is not one of the above
  */
-bool stdinHasData()
+static bool applyMessage(const json& j, Automaton& fsm,
+                         std::vector<Automaton::Injection>& batch)
 {
-    fd_set rfds;
-    FD_ZERO(&rfds);
-    FD_SET(STDIN_FILENO, &rfds);
-    timeval tv{0,0};  // zero-timeout = non-blocking poll
-    return select(STDIN_FILENO+1, &rfds, nullptr, nullptr, &tv) > 0;
+    const std::string type = j.value("type", "");
+    if (type == "inject") {
+        fsm.injectInput(j.at("name").get<std::string>(),
+                        j.at("value").get<std::string>());
+    } 
+    else if (type == "setVar") {
+        // Queued like an input so the variable is written on the run thread
+        Automaton::Injection in;
+        in.kind  = Automaton::Injection::Kind::Variable;
+        in.name  = j.at("name").get<std::string>();
+        in.value = j.at("value").get<std::string>();
+        fsm.injectBatch(&in, 1);
+    }
+    else if (type == "batch") {
+        // Many inject/setVar entries, applied as one unit
+        const auto entries = j.find("entries");
+        if (entries == j.end() || !entries->is_array()) return true;
+        batch.clear();
+        for (const auto& e : *entries) {
+            const auto name  = e.find("name");
+            const auto value = e.find("value");
+            if (name == e.end() || !name->is_string() ||
+                value == e.end() || !value->is_string())
+                continue;
+            const std::string kind = e.value("type", "");
+            Automaton::Injection in;
+            if (kind == "inject")      in.kind = Automaton::Injection::Kind::Input;
+            else if (kind == "setVar") in.kind = Automaton::Injection::Kind::Variable;
+            else continue;
+            in.name  = name->get<std::string>();
+            in.value = value->get<std::string>();
+            batch.push_back(std::move(in));
+        }
+        fsm.injectBatch(batch);
+    }
+    else if (type == "keyframe") {
+        // A client lost track of the deltas
+        fsm.requestKeyframe();
+    }
+    else {
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Logs datagrams the channel dropped as too large since the last call.
+ *
+ * @param chan     Control channel
+ * @param reported Drop count already logged; updated
+ */
+static void reportDropped(const io_bridge::IChannel& chan, std::uint64_t& reported)
+{
+    const auto now = chan.dropped();
+    if (now == reported) return;
+    FSM_LOG(Runtime, Error, "dropped " << (now - reported)
+            << " truncated datagram(s), over " << io_bridge::MAX_DATAGRAM << " bytes");
+    reported = now;
+}
+
+/**
+ * Reads what stdin has available and injects every complete
+ * "name:value" line into the automaton.  Reads the descriptor directly
+ * rather than std::cin, so no line can wait in a stream buffer that the
+ * event loop does not see.
+ *
+ * @param pending Partial line carried over between calls
+ * @param fsm     Automaton receiving the inputs
+ * @return false on end of input (Ctrl-D) or a read error
+ */
+bool readStdin(std::string& pending, Automaton& fsm)
+{
+    char buf[512];
+    const ssize_t n = ::read(STDIN_FILENO, buf, sizeof(buf));
+    if (n < 0) return errno == EINTR || errno == EAGAIN;
+    if (n == 0) return false;
+
+    pending.append(buf, static_cast<std::size_t>(n));
+    std::size_t start = 0;
+    for (std::size_t nl; (nl = pending.find('\n', start)) != std::string::npos; start = nl + 1) {
+        const std::string line = pending.substr(start, nl - start);
+        const auto pos = line.find(':');
+        if (pos != std::string::npos)
+            fsm.injectInput(line.substr(0,pos), line.substr(pos+1));
+    }
+    pending.erase(0, start);
+    return true;
 }
 
 }// namespace ------------------------------------------------------------------
 
 // -----------------------------------------------------------------------------
-// Ctrl‑C handling – set an atomic flag from signal‑handler context
+// HOST MODE – many automata on one work-stealing pool or one reactor thread
 // -----------------------------------------------------------------------------
 
+using WorkerStats = core_fsm::AutomatonHost::WorkerStats;
+
 /**
- * Global flag for graceful shutdown, modified by signal handler.
- * Using atomic_bool to ensure thread-safe access.
+ * Prints per-worker and per-core throughput since the last report.
+ *
+ * @param now     Current counters of every worker
+ * @param prev    Counters at the last report; updated in place
+ * @param elapsed Wall time since the last report
  */
-static std::atomic_bool g_stop{false};
+static void reportThroughput(const std::vector<WorkerStats>& now,
+                             std::vector<WorkerStats>& prev,
+                             std::chrono::duration<double> elapsed)
+{
+    prev.resize(now.size());
+    std::uint64_t total = 0;
+    for (std::size_t w = 0; w < now.size(); ++w) {
+        const std::uint64_t events = now[w].events - prev[w].events;
+        const std::uint64_t steps  = now[w].steps  - prev[w].steps;
+        const double busy = std::chrono::duration<double>(now[w].busy - prev[w].busy).count();
+        total += events;
+        std::cerr << "[fsm_runtime] worker " << w << ": "
+                  << static_cast<std::uint64_t>(events / elapsed.count()) << " events/s, "
+                  << static_cast<std::uint64_t>(steps / elapsed.count()) << " steps/s, "
+                  << static_cast<int>(100.0 * busy / elapsed.count()) << "% busy\n";
+    }
+    std::cerr << "[fsm_runtime] total " << static_cast<std::uint64_t>(total / elapsed.count())
+              << " events/s, " << static_cast<std::uint64_t>(total / elapsed.count() / now.size())
+              << " events/s per core\n";
+    prev = now;
+}
 
 /**
- * Signal handler for SIGINT (Ctrl+C).
- * Sets the global atomic flag to indicate that the program should terminate.
- * 
- * @param signal The signal number (unused)
+ * Feeds control messages from the UDP socket to the hosted automata until
+ * SIGINT or a "shutdown" message, reporting throughput every few seconds
+ * and at the end.
+ *
+ * @param hosted   AutomatonHost or Reactor (size() and automaton(id))
+ * @param loop     Loop watching SIGINT; the socket is added to it
+ * @param bindAddr Local address of the control socket
+ * @param wait     Handles I/O for at most the given time
+ * @param stats    Returns the per-worker counters of @p hosted
+ */
+template <typename Hosted, typename Wait, typename Stats>
+static void serveHosted(Hosted& hosted, io_bridge::EventLoop& loop,
+                        const std::string& bindAddr, Wait wait, Stats stats)
+{
+    auto chan = std::make_shared<io_bridge::UdpChannel>(bindAddr, "127.0.0.1:0");
+
+    using Clock = std::chrono::steady_clock;
+    const auto started = Clock::now();
+    auto lastReport = started;
+    std::vector<WorkerStats> prev;
+    std::vector<Automaton::Injection> batch;
+    std::vector<io_bridge::Packet> inbox;   // Reused across wakeups
+    std::uint64_t dropped = 0;              // Truncated datagrams reported
+    loop.add(chan->fd(), [&](std::uint32_t) {
+        // Up to BATCH_SIZE datagrams per system call; a short batch means
+        // the socket is drained (level-triggered, so nothing is missed)
+        std::size_t n;
+        do {
+            n = chan->pollBatch(inbox, io_bridge::BATCH_SIZE);
+            for (std::size_t i = 0; i < n; ++i) {
+                auto j = json::parse(inbox[i].json, nullptr, false);
+                if (j.is_discarded()) {
+                    FSM_LOG(Runtime, Error, "dropping malformed message ("
+                            << inbox[i].json.size() << " bytes)");
+                    continue;
+                }
+                if (j.value("type", "") == "shutdown") {
+                    loop.stop();
+                    return;
+                }
+                const auto target = j.find("fsm");
+                if (target != j.end() && target->is_number_unsigned()) {
+                    const auto id = target->get<std::size_t>();
+                    if (id < hosted.size()) applyMessage(j, hosted.automaton(id), batch);
+                }
+                else if (target == j.end()) {
+                    for (std::size_t id = 0; id < hosted.size(); ++id)
+                        applyMessage(j, hosted.automaton(id), batch);
+                }
+            }
+        } while (n == io_bridge::BATCH_SIZE);
+        reportDropped(*chan, dropped);
+    });
+
+    // Sleep until a packet or signal arrives, at most until the next report
+    while (!loop.stopped()) {
+        const auto sinceReport = Clock::now() - lastReport;
+        if (sinceReport >= 5s) {
+            reportThroughput(stats(), prev, sinceReport);
+            lastReport = Clock::now();
+            continue;
+        }
+        wait(std::chrono::ceil<std::chrono::milliseconds>(5s - sinceReport));
+    }
+    loop.remove(chan->fd());
+
+    prev.clear();
+    std::cerr << "[fsm_runtime] overall:\n";
+    reportThroughput(stats(), prev, Clock::now() - started);
+}
+
+/**
+ * Removes @p flag from the options right after the mode option (`--host`,
+ * `--replay`), which may come in any order.
+ * @return True if it was there
+ */
+static bool takeFlag(int& argc, char** argv, const std::string& flag)
+{
+    for (int i = 2; i < argc && std::string(argv[i]).rfind("--", 0) == 0; ++i) {
+        if (argv[i] != flag) continue;
+        std::copy(argv + i + 1, argv + argc + 1, argv + i);   // Including the final null
+        --argc;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Runs many automata in one process.
+ *
+ * Usage: `fsm_runtime --host [--rtc] [--js-workers] <workers> <bindAddr> <fsm.json>[:<copies>] ...`
+ *
+ * Every automaton gets its own input queue and timers and is stepped by
+ * an AutomatonHost.  Definitions with JS guards or actions run on one
+ * worker unless `--js-workers` is given: the per-thread engines have not
+ * been validated on several workers against the real QtQml yet.  With 0 workers a Reactor instead steps them on the
+ * main thread, together with the socket: no input crosses threads.
+ * Control messages arriving on the shared UDP socket carry an `"fsm"`
+ * index selecting the automaton (all automata if absent); state snapshots
+ * are not broadcast in this mode.  Throughput is reported every few
+ * seconds and at exit.
+ *
+ * @return 0 on success, 1 on error
+ */
+static int runHost(int argc, char** argv)
+{
+    const bool runToCompletion = takeFlag(argc, argv, "--rtc");
+    const bool jsWorkers       = takeFlag(argc, argv, "--js-workers");
+    if (argc < 5) {
+        std::cerr << "usage: " << argv[0]
+                  << " --host [--rtc] [--js-workers] <workers> <bindAddr> <fsm.json>[:<copies>] ...\n"
+                  << "       (0 workers: run everything on one reactor thread)\n";
+        return 1;
+    }
+    std::size_t workers = std::strtoul(argv[2], nullptr, 10);
+    const std::string bindAddr = argv[3];
+
+    // 1) Load & build every requested copy ------------------------------------
+    std::vector<std::unique_ptr<Automaton>> automata;
+    std::size_t scriptUses = 0;
+    for (int a = 4; a < argc; ++a) {
+        std::string path = argv[a];
+        std::size_t copies = 1;
+        const auto colon = path.rfind(':');
+        if (colon != std::string::npos && colon + 1 < path.size() &&
+            path.find_first_not_of("0123456789", colon + 1) == std::string::npos) {
+            copies = std::strtoul(path.c_str() + colon + 1, nullptr, 10);
+            path.resize(colon);
+        }
+
+        core_fsm::persistence::FsmDocument doc;
+        std::string err;
+        if (!core_fsm::persistence::loadFile(path, doc, &err)) {
+            std::cerr << "[fsm_runtime] ERROR: cannot load '" << path << "' – " << err << "\n";
+            return 1;
+        }
+        if (copies == 0) continue;
+
+        // Build the model once; the other copies share it.  Small input
+        // queues: thousands of automata share the process
+        auto fsm = std::make_unique<Automaton>(Scheduler::Backend::Heap, 64);
+        scriptUses += copies * buildFromDocument(doc, *fsm);
+        fsm->setRunToCompletion(runToCompletion);
+        const auto model = fsm->share();
+        automata.push_back(std::move(fsm));
+        for (std::size_t c = 1; c < copies; ++c)
+            automata.push_back(std::make_unique<Automaton>(model, Scheduler::Backend::Heap, 64));
+    }
+    // Every thread gets its own JS engines, but guard/action evaluation on
+    // several workers is still unproven against QtQml: opt in for now
+    if (scriptUses > 0 && workers > 1 && !jsWorkers) {
+        std::cerr << "[fsm_runtime] " << scriptUses
+                  << " actions/guards need the JS engine – running on 1 worker"
+                  << " (--js-workers to use " << workers << ")\n";
+        workers = 1;
+    }
+
+    auto announce = [&](std::size_t count, const char* where) {
+        std::cerr << "[fsm_runtime] hosting " << count << " automata " << where;
+        if (scriptUses > 0)
+            std::cerr << " (" << scriptUses << " JS actions/guards, one engine per thread)";
+        std::cerr << "\n";
+    };
+
+    // 2a) Reactor: automata, timers, socket and signals on this thread --------
+    if (workers == 0) {
+        core_fsm::Reactor reactor;
+        io_bridge::EventLoop& loop = reactor.loop();
+        if (!loop.valid()) {
+            std::cerr << "[fsm_runtime] ERROR: cannot create the event loop\n";
+            return 1;
+        }
+        loop.watchSignal(SIGINT, [&loop](int) { loop.stop(); });
+        for (auto& fsm : automata)
+            reactor.add(std::move(fsm));
+        automata.clear();
+        announce(reactor.size(), "on one reactor thread");
+
+        reactor.start();
+        serveHosted(reactor, loop, bindAddr,
+                    [&](std::chrono::milliseconds t) { reactor.runOnce(t); },
+                    [&] {
+                        const auto st = reactor.stats();
+                        return std::vector<WorkerStats>{ WorkerStats{st.steps, st.events, st.busy} };
+                    });
+        return 0;
+    }
+
+    // 2b) Pool: the main thread only handles the socket ------------------------
+    // SIGINT goes through the loop; block it before the pool threads start
+    io_bridge::EventLoop loop;
+    if (!loop.valid()) {
+        std::cerr << "[fsm_runtime] ERROR: cannot create the event loop\n";
+        return 1;
+    }
+    loop.watchSignal(SIGINT, [&loop](int) { loop.stop(); });
+
+    core_fsm::AutomatonHost host(workers);
+    for (auto& fsm : automata)
+        host.add(std::move(fsm));
+    automata.clear();
+    announce(host.size(), ("on " + std::to_string(host.workers()) + " workers").c_str());
+
+    host.start();
+    serveHosted(host, loop, bindAddr,
+                [&](std::chrono::milliseconds t) { loop.runOnce(t); },
+                [&] { return host.stats(); });
+    host.stop();
+    return 0;
+}
+
+/**
+ * Replays a recorded input trace against an FSM definition.
+ *
+ * Usage: `fsm_runtime --replay [--rtc] <fsm.json> <trace>`
+ *
+ * The automaton is built as for a normal run but without a channel, fed
+ * the trace in virtual time as fast as it executes, and its state entries
+ * compared with the recorded ones.  It runs with the settings stored in
+ * the trace; `--rtc` only matters for traces of the first format, which
+ * did not store them.
+ *
+ * @return 0 if the replay matches the recording, 1 otherwise
  */
-static void onSigInt(int){ g_stop = true; }
+static int runReplay(int argc, char** argv)
+{
+    const bool runToCompletion = takeFlag(argc, argv, "--rtc");
+    if (argc < 4) {
+        std::cerr << "usage: " << argv[0] << " --replay [--rtc] <fsm.json> <trace>\n";
+        return 1;
+    }
+
+    core_fsm::persistence::FsmDocument doc;
+    std::string err;
+    if (!core_fsm::persistence::loadFile(argv[2], doc, &err)) {
+        std::cerr << "[fsm_runtime] ERROR: cannot load '" << argv[2] << "' – " << err << "\n";
+        return 1;
+    }
+    core_fsm::Automaton fsm;
+    buildFromDocument(doc, fsm, false);
+    fsm.setRunToCompletion(runToCompletion);
+
+    core_fsm::ReplayReport report;
+    try {
+        core_fsm::TraceReader trace(argv[3]);
+        if (const auto& s = trace.settings())
+            std::cout << "[fsm_runtime] trace recorded with run-to-completion "
+                      << (s->runToCompletion ? "on" : "off") << ", "
+                      << s->maxMicrosteps << " microsteps per step\n";
+        report = core_fsm::replayTrace(fsm, trace);
+    }
+    catch (const std::exception& e) {
+        std::cerr << "[fsm_runtime] ERROR: " << e.what() << "\n";
+        return 1;
+    }
+
+    const double secs = std::chrono::duration<double>(report.wall).count();
+    std::cout << "[fsm_runtime] replayed " << report.inputs << " inputs, "
+              << report.transitions << " transitions in " << secs * 1e3 << " ms ("
+              << (secs > 0 ? report.transitions / secs : 0.0) << " transitions/s)\n";
+    if (!report.matches) {
+        std::cout << "[fsm_runtime] MISMATCH at entry " << report.mismatch << " (recorded "
+                  << report.expected << " entries, replay produced " << report.transitions << ")\n";
+        return 1;
+    }
+    std::cout << "[fsm_runtime] replay matches the recording (" << report.expected
+              << " entries, max timestamp skew "
+              << std::chrono::duration<double, std::micro>(report.maxSkew).count() << " us)\n";
+    return 0;
+}
 
 // -----------------------------------------------------------------------------
 // MAIN
@@ -205,6 +638,18 @@ static void onSigInt(int){ g_stop = true; }
 /**
  * Main entry point for the FSM runtime.
  * Loads an FSM definition, constructs the automaton, and runs it with IO handling.
+ * Options may precede the arguments: `--record <trace>` writes every input
+ * consumed to a trace for `--replay`; `--delta <N>` broadcasts snapshots as
+ * deltas with a full keyframe every N messages; `--log <spec>` sets log
+ * levels (e.g. `snapshot=debug,timer=debug`, the old verbose output);
+ * `--publish <every|state|ms>` coalesces snapshots (on state change only,
+ * or at most one per ms interval); `--wire <json|msgpack|cbor>` limits the snapshot encodings a client's
+ * `hello` may pick (json keeps text packets for debugging);
+ * `--send-queue <slots>[:drop|coalesce]` sizes the ring feeding the
+ * snapshot sender thread and picks what happens when it is full (0 sends
+ * inline on the automaton thread; default 64:coalesce); `--rtc` fires
+ * undelayed transitions within the step that enables them instead of
+ * through a 1 ms timer (see Automaton::setRunToCompletion()).
  * 
  * @param argc Number of command-line arguments
  * @param argv Array of command-line argument strings
@@ -213,10 +658,96 @@ static void onSigInt(int){ g_stop = true; }
 int main(int argc, char** argv)
 {
     QCoreApplication app(argc, argv);
+    if (argc > 1 && std::string(argv[1]) == "--host")
+        return runHost(argc, argv);
+    if (argc > 1 && std::string(argv[1]) == "--replay")
+        return runReplay(argc, argv);
+
+    // Options preceding the usual arguments
+    std::string recordPath;                          // --record target, if any
+    std::size_t keyframeEvery = 0;
+    std::optional<io_bridge::WireFormat> wireOnly;   // Binary format offered, if restricted
+    Automaton::PublishPolicy publish;                // Every event by default
+    std::size_t sendQueue = 64;                      // Snapshot ring slots; 0 = send inline
+    auto overflow = io_bridge::SnapshotSender::Overflow::Coalesce;
+    bool runToCompletion = false;
+    while (argc > 2 && std::string(argv[1]).rfind("--", 0) == 0) {
+        const std::string opt = argv[1];
+        if (opt == "--rtc") {
+            runToCompletion = true;
+            --argc;
+            ++argv;
+            continue;
+        }
+        if (opt == "--record") {
+            recordPath = argv[2];
+        }
+        else if (opt == "--delta") {
+            keyframeEvery = std::strtoul(argv[2], nullptr, 10);
+        }
+        else if (opt == "--publish") {
+            const std::string mode = argv[2];
+            if (mode == "every")
+                publish = Automaton::PublishPolicy::everyEvent();
+            else if (mode == "state")
+                publish = Automaton::PublishPolicy::onStateChange();
+            else if (!mode.empty() && mode.find_first_not_of("0123456789") == std::string::npos)
+                publish = Automaton::PublishPolicy::atMostEvery(
+                    std::chrono::milliseconds(std::strtoul(mode.c_str(), nullptr, 10)));
+            else {
+                std::cerr << "[fsm_runtime] ERROR: --publish takes every, state or <ms>\n";
+                return 1;
+            }
+        }
+        else if (opt == "--wire") {
+            wireOnly = io_bridge::parseFormat(argv[2]);
+            if (!wireOnly) {
+                std::cerr << "[fsm_runtime] ERROR: unknown wire format '" << argv[2] << "'\n";
+                return 1;
+            }
+        }
+        else if (opt == "--send-queue") {
+            const std::string spec = argv[2];
+            const auto colon = spec.find(':');
+            const std::string slots = spec.substr(0, colon);
+            const auto policy = colon == std::string::npos
+                ? std::optional(overflow)
+                : io_bridge::SnapshotSender::parseOverflow(spec.substr(colon + 1));
+            if (slots.empty() || slots.find_first_not_of("0123456789") != std::string::npos || !policy) {
+                std::cerr << "[fsm_runtime] ERROR: --send-queue takes <slots>[:drop|coalesce]\n";
+                return 1;
+            }
+            sendQueue = std::strtoul(slots.c_str(), nullptr, 10);
+            overflow  = *policy;
+        }
+        else if (opt == "--log") {
+            if (!core_fsm::log::configure(argv[2])) {
+                std::cerr << "[fsm_runtime] ERROR: bad log spec '" << argv[2] << "'\n";
+                return 1;
+            }
+        }
+        else {
+            std::cerr << "[fsm_runtime] ERROR: unknown option '" << opt << "'\n";
+            return 1;
+        }
+        argc -= 2;
+        argv += 2;
+    }
+
     const std::string fsmPath  = (argc > 1 ? argv[1] : "../examples/TOF.fsm.json");
     const std::string bindAddr = (argc > 2 ? argv[2] : "0.0.0.0:45454");
     const std::string peerAddr = (argc > 3 ? argv[3] : "127.0.0.1:45455");
 
+    // 0) Event loop ------------------------------------------------------------
+    // SIGINT is delivered through the loop; block it before any thread starts
+    // (the log writer, the snapshot sender, the interpreter)
+    io_bridge::EventLoop loop;
+    if (!loop.valid()) {
+        std::cerr << "[fsm_runtime] ERROR: cannot create the event loop\n";
+        return 1;
+    }
+    loop.watchSignal(SIGINT, [&loop](int) { loop.stop(); });
+
     // 1) Load & build ---------------------------------------------------------
     // Parse the JSON FSM definition and construct the automaton
     core_fsm::persistence::FsmDocument doc;
@@ -229,59 +760,109 @@ int main(int argc, char** argv)
     core_fsm::Automaton fsm;
     buildFromDocument(doc, fsm);
 
+    fsm.setRunToCompletion(runToCompletion);
+
+    // The trace header records the settings a replay needs to match
+    std::unique_ptr<core_fsm::TraceWriter> recorder;
+    if (!recordPath.empty()) {
+        try {
+            recorder = std::make_unique<core_fsm::TraceWriter>(recordPath,
+                core_fsm::TraceSettings{fsm.runToCompletion(),
+                                        static_cast<std::uint32_t>(fsm.maxMicrosteps())});
+        }
+        catch (const std::exception& e) {
+            std::cerr << "[fsm_runtime] ERROR: " << e.what() << "\n";
+            return 1;
+        }
+    }
+    fsm.setRecorder(recorder.get());
+    fsm.setDeltaSnapshots(keyframeEvery);
+    fsm.setPublishPolicy(publish);
+
     // 2) Networking -----------------------------------------------------------
     // Set up UDP communication channel for remote control and monitoring
     auto chan = std::make_shared<io_bridge::UdpChannel>(bindAddr, peerAddr);
     fsm.attachChannel(chan);   // Automaton will take care of state broadcasts
+    std::shared_ptr<io_bridge::SnapshotSender> sender;
+    if (sendQueue > 0) {
+        // Encode and send snapshots off the automaton thread
+        sender = std::make_shared<io_bridge::SnapshotSender>(chan, sendQueue, overflow);
+        fsm.attachSender(sender);
+    }
 
     // 3) Run interpreter in worker thread ------------------------------------
     // Start FSM execution in a separate thread
     std::thread runner([&]{ fsm.run(); });
 
-    // 4) Event loop: forward UDP → injectInput  (+ optional stdin for testing)
-    // Set up signal handling for graceful termination
-    std::signal(SIGINT, onSigInt);
-
-    while (!g_stop) {
-        // 4a) UDP -------------------------------------------------------------
-        // Process incoming UDP packets (remote inputs and commands)
-        io_bridge::Packet p;
-        while (chan->poll(p)) {
-            auto j = json::parse(p.json, nullptr, false);
-            if (j.is_discarded()) continue;
-
-            const std::string type = j.value("type", "");
-            if (type == "inject") {
-                fsm.injectInput(j.at("name").get<std::string>(),
-                                j.at("value").get<std::string>());
-            } 
-            else if (type == "setVar") {
-                fsm.setVariable(j.at("name").get<std::string>(), j.at("value").get<std::string>());
-            }
-            else if (type == "shutdown") {
-                g_stop = true;
-            }
-        }
+    // 3a) UDP -----------------------------------------------------------------
+    // Process incoming UDP packets (remote inputs and commands) as they arrive
+    std::vector<Automaton::Injection> batch;   // Reused across "batch" messages
+    std::vector<io_bridge::Packet> inbox;      // Reused across wakeups
+    std::uint64_t dropped = 0;                 // Truncated datagrams reported
+    loop.add(chan->fd(), [&](std::uint32_t) {
+        // Up to BATCH_SIZE datagrams per system call; a short batch means
+        // the socket is drained (level-triggered, so nothing is missed)
+        std::size_t n;
+        do {
+            n = chan->pollBatch(inbox, io_bridge::BATCH_SIZE);
+            for (std::size_t i = 0; i < n; ++i) {
+                FSM_LOG(Runtime, Debug, "UDP → RUNTIME: " << inbox[i].json);
+                auto j = json::parse(inbox[i].json, nullptr, false);
+                if (j.is_discarded()) {
+                    FSM_LOG(Runtime, Error, "dropping malformed message ("
+                            << inbox[i].json.size() << " bytes)");
+                    continue;
+                }
 
-        // 4b) Stdin -----------------------------------------------------------
-        // Allow local input injection via terminal for testing
-        if (stdinHasData()) {
-            std::string line;
-            std::getline(std::cin, line);
-            const auto pos = line.find(':');
-            if (pos != std::string::npos)
-                fsm.injectInput(line.substr(0,pos), line.substr(pos+1));
-        } else if (std::cin.eof()) {
-            // Ctrl-D = graceful shutdown
-            g_stop = true;
-        }
+                if (applyMessage(j, fsm, batch)) continue;
+                const std::string type = j.value("type", "");
+                if (type == "shutdown") {
+                    loop.stop();
+                }
+                else if (type == "hello") {
+                    // Capability handshake: the client's first format we also speak
+                    io_bridge::WireFormat chosen = io_bridge::WireFormat::Json;
+                    for (const auto& name : j.value("formats", json::array())) {
+                        const auto f = name.is_string() ? io_bridge::parseFormat(name.get<std::string>())
+                                                        : std::nullopt;
+                        if (f && (*f == io_bridge::WireFormat::Json || !wireOnly || *f == *wireOnly)) {
+                            chosen = *f;
+                            break;
+                        }
+                    }
+                    // Answer before switching, so no binary snapshot overtakes the reply
+                    chan->send({ json{{"type", "hello"}, {"format", io_bridge::formatName(chosen)}}.dump() });
+                    fsm.setWireFormat(chosen);
+                    fsm.requestKeyframe();
+                }
+            }
+        } while (n == io_bridge::BATCH_SIZE);
+        reportDropped(*chan, dropped);
+    });
 
-        std::this_thread::sleep_for(10ms);
+    // 3b) Stdin ---------------------------------------------------------------
+    // Allow local input injection via terminal for testing; Ctrl-D = graceful
+    // shutdown.  Stdin redirected from a file cannot be polled: read it at once
+    std::string stdinLine;
+    const bool stdinWatched = loop.add(STDIN_FILENO, [&](std::uint32_t) {
+        if (!readStdin(stdinLine, fsm)) loop.stop();
+    });
+    if (!stdinWatched) {
+        while (readStdin(stdinLine, fsm)) {}
+        loop.stop();
     }
 
-    // 5) Graceful shutdown ----------------------------------------------------
+    loop.run();
+
+    // 4) Graceful shutdown ----------------------------------------------------
     // Stop the FSM and wait for the worker thread to complete
     fsm.requestStop();
     runner.join();
+    if (recorder) {
+        recorder->flush();
+        std::cerr << "[fsm_runtime] recorded " << recorder->records() << " trace records\n";
+    }
+    if (sender && sender->dropped() > 0)
+        std::cerr << "[fsm_runtime] " << sender->dropped() << " snapshots dropped (send queue full)\n";
     return 0;
 }
@@ -281,7 +281,11 @@ void MainWindow::on_actionBuildRun_triggered()
             m_interpreter, &QObject::deleteLater);
 
     QString exe = QCoreApplication::applicationDirPath() + "/fsm_runtime";
-    m_interpreter->start(exe, { tmp,
+    // Deltas with a keyframe every 32 messages; RuntimeClient rebuilds them.
+    // At most one snapshot per 20 ms poll of the client, the last one kept
+    m_interpreter->start(exe, { "--delta", "32",
+                                "--publish", "20",
+                                tmp,
                                 "0.0.0.0:45454",
                                 "127.0.0.1:45455" });
     if (!m_interpreter->waitForStarted()) {
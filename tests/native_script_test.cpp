@@ -0,0 +1,295 @@
+/**
+ * @file   native_script_test.cpp
+ * @brief  Differential test of the native inscription evaluator against
+ *         QJSEngine.
+ *
+ * Every guard and action of the tables below is run twice: natively
+ * (native::Program) and through the JS engine exactly as the runtime does
+ * when the native compiler declines (script::registerFunction() plus the
+ * guard/action helpers).  The results must agree.  Sources outside the
+ * native subset must be rejected by the native compiler, so that the
+ * caller falls back to the JS engine instead of guessing.
+ *
+ * Exit status 0 when every case passes.
+ *
+ * @author Martin Ševčík (xsevcim00)
+ * @author Jakub Lůčný (xlucnyj00)
+ * @date   2025-05-06
+ */
+
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include <QJSEngine>
+#include <QJSValue>
+#include <QString>
+
+#include "context.hpp"
+#include "native_script.hpp"
+#include "script_engine.hpp"
+#include "slots.hpp"
+#include "variable.hpp"
+
+using namespace core_fsm;
+
+namespace {
+
+using Inputs = std::vector<std::pair<std::string, std::string>>;
+
+/// Guard evaluated natively and by the JS engine, or expected to fall back.
+struct GuardCase {
+    const char* src;
+    bool        native;   ///< False: the native compiler must reject it
+};
+
+/// Entry action compared on the variables and outputs it leaves behind.
+struct ActionCase {
+    const char*           src;
+    std::vector<Variable> vars;
+    Inputs                inputs;
+    bool                  native;   ///< False: the native compiler must reject it
+};
+
+/*
+ * Guards, evaluated against inputs in = "1", x = " 12 ", e = "" and
+ * variables timeout = 5000 (int), f = 3.1 (double), s = "abc" (string).
+ */
+const std::vector<GuardCase> kGuards = {
+    // valueof / defined / atoi on inputs and variables
+    { R"(atoi(valueof("in")) == 1)",                   true  },
+    { R"(atoi(valueof("in")) == 0)",                   true  },
+    { R"(valueof("timeout") == 5000)",                 true  },
+    { R"(valueof("f") > 20)",                          true  },
+    { R"(valueof("f") > 3)",                           true  },
+    { R"(valueof("f") == 3.1)",                        true  },
+    { R"(defined("in") && !defined("zz"))",            true  },
+    { R"(defined("timeout"))",                         true  },
+    { R"(valueof("x") == 12)",                         true  },
+    { R"(atoi(valueof("x")) + 1 === 13)",              true  },
+    { R"(valueof("s") < "abd")",                       true  },
+    { R"(valueof("s") + 1 == "abc1")",                 true  },
+    { R"(valueof("e") == 0)",                          true  },
+    { R"(valueof("zz") == "")",                        true  },
+    { R"(atoi(valueof("zz")) == atoi(valueof("zz")))", true  },   // NaN != NaN
+    { R"(valueof("in") === "1";)",                     true  },
+    // Operators, precedence and conversions
+    { R"(1 + 2 * 3 % 4 - -1 == 8)",                    true  },
+    { R"("10" < "9")",                                 true  },
+    { R"("10" < 9)",                                   true  },
+    { R"(true == 1)",                                  true  },
+    { R"((1 || 0) && "x")",                            true  },
+    { R"(0 || "")",                                    true  },
+    { R"(atoi("0x1F") == 0)",                          true  },
+    { R"(atoi(3.9e2) == 390)",                         true  },
+    { R"(0x10 == 16)",                                 true  },
+    { R"(.5 + .5 == 1)",                               true  },
+    // Outside the subset
+    { R"(foo == 1)",                                   false },   // free identifier
+    { R"(valueof(x) == 1)",                            false },   // non-literal name
+    { R"(elapsed() > 2)",                              false },   // action-only helper
+    { R"(1 = 1)",                                      false },   // assignment
+    { R"(Math.max(1, 2) == 2)",                        false },   // member access
+};
+
+using T = Variable::Type;
+
+/// Entry actions of the example models and a few conversion corner cases.
+const std::vector<ActionCase> kActions = {
+    { "if(valueof(\"in\") == \"x\"){\n    x++;\n}\nif(valueof(\"in\") == \"y\"){\n    y++;\n}\n",
+      { {"x", T::Int, 0}, {"y", T::Int, 0} }, { {"in", "x"} }, true },
+    { "output(\"x_cnt\", x);\noutput(\"y_cnt\", y);",
+      { {"x", T::Int, 3}, {"y", T::Int, 0} }, {}, true },
+    { "f = f + 1.7;\noutput(\"res\", f);",
+      { {"f", T::Double, 3.1} }, {}, true },
+    { "if (defined(\"set_to\")) {\n    timeout = atoi(valueof(\"set_to\"));\n}\n"
+      "output(\"out\", 1);\noutput(\"rt\", timeout);",
+      { {"timeout", T::Int, 5000} }, { {"set_to", "1200"}, {"in", "1"} }, true },
+    { "if (defined(\"set_to\")) {\n    timeout = atoi(valueof(\"set_to\"));\n}\n"
+      "output(\"out\", 1);\noutput(\"rt\", timeout);",
+      { {"timeout", T::Int, 5000} }, {}, true },
+    { "output(\"rt\", timeout - elapsed());",
+      { {"timeout", T::Int, 5000} }, {}, true },
+    { "output(\"green\", 1);\np_wait_signal = 0;\n"
+      "if (defined(\"set_green\")) {\n    green_dura = atoi(valueof(\"set_green\"));\n}\n",
+      { {"green_dura", T::Int, 1500}, {"p_wait_signal", T::Int, 1} },
+      { {"set_green", "abc"} }, true },
+    { "s = 5; output(\"o\", s + 1); n = \"7\" ; output(\"p\", n * 2)",
+      { {"s", T::String, std::string("a")}, {"n", T::Int, 0} }, {}, true },
+    { "n = 2.7; output(\"o\", n); n += \"1\"; output(\"q\", valueof(\"n\"))",
+      { {"n", T::Int, 0} }, {}, true },
+    { "if (valueof(\"k\") == 0) output(\"z\", \"yes\")\nelse { output(\"z\", \"no\") }",
+      { {"k", T::Int, 0} }, {}, true },
+    { "x = x - 1\ny = !x",
+      { {"x", T::Int, 1}, {"y", T::String, std::string("")} }, {}, true },
+    // Outside the subset
+    { "var q = 1", {}, {}, false },
+    { "undeclared = 1", { {"x", T::Int, 0} }, {}, false },
+    { "for (x = 0; x < 3; x++) output(\"o\", x)", { {"x", T::Int, 0} }, {}, false },
+};
+
+/// Printable form of a variable value.
+std::string show(const Value& value)
+{
+    std::ostringstream out;
+    out.precision(17);
+    std::visit([&](auto&& x) { out << x; }, value);
+    return out.str();
+}
+
+/// Set slots of @p slots by name.
+std::map<std::string, std::string> contents(const IOSlots& slots)
+{
+    std::map<std::string, std::string> m;
+    for (SymbolId id = 0; id < slots.size(); ++id)
+        if (slots.has(id)) m.emplace(slots.name(id), slots.get(id));
+    return m;
+}
+
+/// Variables of @p slots by name, with their type index.
+std::map<std::string, std::string> contents(const VarSlots& slots)
+{
+    std::map<std::string, std::string> m;
+    for (SymbolId id = 0; id < slots.size(); ++id)
+        m.emplace(slots.name(id), std::to_string(slots.value(id).index()) + ":" + show(slots.value(id)));
+    return m;
+}
+
+/// Evaluate @p src the way Transition does when the native compiler declines.
+bool scriptGuard(const std::string& src, script::JsContext& js,
+                 const VarSlots& vars, const IOSlots& inputs, std::string& error)
+{
+    const script::FunctionId id = script::registerFunction(script::Dialect::Guard,
+        QString("(function(){ return %1; })").arg(QString::fromStdString(src)));
+    js.syncInputs(inputs);
+    js.syncVars(vars);
+    js.install();
+    QJSValue result = script::function(id).call();
+    if (result.isError()) error = result.toString().toStdString();
+    return result.toBool();
+}
+
+/// Run @p src the way the runtime runs a JS entry action.
+void scriptAction(const std::string& src, Context& ctx)
+{
+    const script::FunctionId id = script::registerFunction(script::Dialect::Action,
+        "(function(){ " + QString::fromStdString(src) + "; })");
+    QJSEngine& eng = script::engine();
+    script::bindCtx(eng, ctx);
+    QJSValue fn = script::function(id);
+    if (fn.isCallable()) fn.call();
+    script::pullBack(eng, ctx);
+}
+
+int checkGuards()
+{
+    VarSlots vars;
+    vars.add({"timeout", T::Int, 5000});
+    vars.add({"f", T::Double, 3.1});
+    vars.add({"s", T::String, std::string("abc")});
+    IOSlots inputs;
+    inputs.set("in", "1");
+    inputs.set("x", " 12 ");
+    inputs.set("e", "");
+    script::JsContext engine{script::Dialect::Guard};
+
+    int failures = 0;
+    for (const GuardCase& c : kGuards) {
+        std::string why;
+        auto prog = native::Program::compileGuard(c.src, &why);
+        if (!c.native) {
+            if (prog) {
+                std::cerr << "FAIL guard " << c.src << ": expected a fallback, compiled natively\n";
+                ++failures;
+            }
+            continue;
+        }
+        if (!prog) {
+            std::cerr << "FAIL guard " << c.src << ": fell back (" << why << ")\n";
+            ++failures;
+            continue;
+        }
+        prog->bind(inputs, vars);
+        const bool native = prog->test(vars, inputs);
+        std::string error;
+        const bool js = scriptGuard(c.src, engine, vars, inputs, error);
+        if (!error.empty() || native != js) {
+            std::cerr << std::boolalpha << "FAIL guard " << c.src << ": native " << native
+                      << ", js " << js << (error.empty() ? "" : " (" + error + ")") << "\n";
+            ++failures;
+        }
+    }
+    return failures;
+}
+
+int checkActions()
+{
+    const auto now = Clock::now();
+    const auto since = now - std::chrono::milliseconds(250);
+
+    int failures = 0;
+    for (const ActionCase& c : kActions) {
+        // Both runs start from their own copy of the case's slots
+        VarSlots vars, jsVars;
+        IOSlots inputs, outputs, jsInputs, jsOutputs;
+        for (const Variable& v : c.vars) {
+            vars.add(v);
+            jsVars.add(v);
+        }
+        for (const auto& [name, value] : c.inputs) {
+            inputs.set(name, value);
+            jsInputs.set(name, value);
+        }
+
+        std::string why;
+        auto prog = native::Program::compileAction(c.src, vars, &why);
+        if (!c.native) {
+            if (prog) {
+                std::cerr << "FAIL action " << c.src << ": expected a fallback, compiled natively\n";
+                ++failures;
+            }
+            continue;
+        }
+        if (!prog) {
+            std::cerr << "FAIL action " << c.src << ": fell back (" << why << ")\n";
+            ++failures;
+            continue;
+        }
+
+        prog->bind(inputs, vars, &outputs);
+        Context nativeCtx(vars, inputs, outputs, since, now);
+        prog->run(nativeCtx);
+
+        Context jsCtx(jsVars, jsInputs, jsOutputs, since, now);
+        scriptAction(c.src, jsCtx);
+
+        if (contents(vars) != contents(jsVars) || contents(outputs) != contents(jsOutputs)) {
+            std::cerr << "FAIL action " << c.src << "\n";
+            for (const auto& [name, value] : contents(vars))
+                std::cerr << "  native var " << name << " = " << value << "\n";
+            for (const auto& [name, value] : contents(jsVars))
+                std::cerr << "  js     var " << name << " = " << value << "\n";
+            for (const auto& [name, value] : contents(outputs))
+                std::cerr << "  native out " << name << " = " << value << "\n";
+            for (const auto& [name, value] : contents(jsOutputs))
+                std::cerr << "  js     out " << name << " = " << value << "\n";
+            ++failures;
+        }
+    }
+    return failures;
+}
+
+} // namespace
+
+int main()
+{
+    const int failures = checkGuards() + checkActions();
+    std::cout << kGuards.size() << " guards, " << kActions.size() << " actions, "
+              << failures << " failures\n";
+    return failures == 0 ? 0 : 1;
+}